@@ -0,0 +1,210 @@
+#pragma once
+
+#include <assert.h>
+#include <vector>
+
+#include "Vector.h"
+#include "threadpool.h"
+#include "TridiagonalMatrix.h"
+#include "TridiagonalFactorization.h"
+
+/**
+ * @brief PartitionedTridiagonalFactorization A factorization of a TridiagonalMatrix which solves
+ *        the system on multiple threads with the partition method.
+ * The rows get split into one block per thread. The last row of every block is an interface row
+ * with the unknown \f$ z_k \f$, all other rows of the block are its interior. The interior of a
+ * block only couples to the interface rows around it, so it can be solved independently:
+ * \f[
+ *      x_i = y_i + v_i z_{k-1} + w_i z_k
+ * \f]
+ * with the spikes \f$ v \f$ and \f$ w \f$, which only depend on the matrix. Inserting this into the
+ * interface rows results in a small tridiagonal system for the \f$ z_k \f$, which gets solved by one
+ * thread before every block computes its final values. The naming follows TridiagonalMatrix::solve.
+ */
+template <typename T>
+class PartitionedTridiagonalFactorization
+{
+public:
+    /**
+     * @brief MinimumBlockSize The smallest number of rows per block. Smaller systems
+     *        should be solved with the sequential TridiagonalFactorization.
+     */
+    static const unsigned int MinimumBlockSize = 16384;
+
+    /**
+     * @brief #isSuitable Check if a system of the given size should be partitioned over the threads.
+     * @param size The size of the system.
+     * @param threads The number of available threads.
+     * @return True if every thread gets at least MinimumBlockSize rows, otherwise false.
+     */
+    static bool isSuitable(unsigned int size, unsigned int threads) {
+        return threads > 1 && size / threads >= MinimumBlockSize;
+    }
+
+    /**
+     * @brief PartitionedTridiagonalFactorization Default constructor for an empty factorization.
+     */
+    PartitionedTridiagonalFactorization() : size(0) {
+    }
+
+    /**
+     * @brief #factorize Factorize the interior of all blocks and the reduced interface system.
+     *                   The storage gets reused if the size did not change.
+     * @param mat The matrix to factorize.
+     * @param pool The threads to factorize the blocks with, one block is used per thread.
+     * @require The matrix must have at least two rows per block.
+     */
+    void factorize(const TridiagonalMatrix<T>& mat, ThreadPool& pool) {
+        typedef TridiagonalMatrix<T> Matrix;
+        const unsigned int blocks = pool.getThreadCount();
+        assert(mat.getSize() >= 2 * blocks);
+        size = mat.getSize();
+        multiplier.resize(size);
+        pivot.resize(size);
+        upper.resize(size);
+        leftSpike.resize(size);
+        rightSpike.resize(size);
+        begin.resize(blocks + 1);
+        couplings.resize(blocks);
+        for (unsigned int k = 0; k <= blocks; ++k) {
+            begin[k] = static_cast<unsigned int>(static_cast<unsigned long long>(size) * k / blocks);
+        }
+
+        pool.run([&] (unsigned int k) {
+            const unsigned int first = begin[k];
+            const unsigned int last = begin[k + 1] - 2;
+
+            pivot[first] = T(1) / mat(Matrix::Diagonal, first);
+            multiplier[first] = mat(Matrix::Lower, first) * pivot[first];
+            upper[first] = mat(Matrix::Upper, first);
+            for (unsigned int i = first + 1; i <= last; ++i) {
+                upper[i] = mat(Matrix::Upper, i);
+                pivot[i] = T(1) / (mat(Matrix::Diagonal, i) - upper[i] * multiplier[i - 1]);
+                multiplier[i] = mat(Matrix::Lower, i) * pivot[i];
+            }
+
+            // the spikes are the interior solutions for the couplings to the surrounding interface rows
+            leftSpike[first] = (k > 0 ? -upper[first] : T(0)) * pivot[first];
+            rightSpike[first] = (first == last ? -mat(Matrix::Lower, last) : T(0)) * pivot[first];
+            for (unsigned int i = first + 1; i <= last; ++i) {
+                leftSpike[i] = -upper[i] * leftSpike[i - 1] * pivot[i];
+                rightSpike[i] = ((i == last ? -mat(Matrix::Lower, last) : T(0)) - upper[i] * rightSpike[i - 1]) * pivot[i];
+            }
+            for (unsigned int i = last; i-- > first;) {
+                leftSpike[i] -= multiplier[i] * leftSpike[i + 1];
+                rightSpike[i] -= multiplier[i] * rightSpike[i + 1];
+            }
+        });
+
+        if (reduced.getSize() != blocks) {
+            reduced = TridiagonalMatrix<T>(blocks);
+            reducedValues = Vector<T>(blocks);
+        }
+        for (unsigned int k = 0; k < blocks; ++k) {
+            const unsigned int row = begin[k + 1] - 1;
+            couplings[k].upper = mat(Matrix::Upper, row);
+            couplings[k].lower = k + 1 < blocks ? mat(Matrix::Lower, row) : T(0);
+            reduced(Matrix::Upper, k) = couplings[k].upper * leftSpike[row - 1];
+            reduced(Matrix::Diagonal, k) = mat(Matrix::Diagonal, row) + couplings[k].upper * rightSpike[row - 1];
+            if (k + 1 < blocks) {
+                reduced(Matrix::Diagonal, k) += couplings[k].lower * leftSpike[row + 1];
+                reduced(Matrix::Lower, k) = couplings[k].lower * rightSpike[row + 1];
+            }
+        }
+        reducedFactorization.factorize(reduced);
+    }
+
+    /**
+     * @brief #propagate Compute \f$ x = A^{-1} R v \f$ inplace for the factorized matrix \f$ A \f$
+     *                   like TridiagonalFactorization::propagate, but distributed over the threads.
+     * @param right The matrix \f$ R \f$ to multiply the vector with before solving.
+     * @param vec The vector \f$ v \f$ which gets replaced by \f$ x \f$.
+     * @param pool The threads to solve the blocks with, this must be the pool used for #factorize.
+     * @require The matrix and the vector must have the same size as the factorized matrix.
+     */
+    void propagate(const TridiagonalMatrix<T>& right, Vector<T>& vec, ThreadPool& pool) {
+        typedef TridiagonalMatrix<T> Matrix;
+        const unsigned int blocks = getBlockCount();
+        assert(size == vec.size() && size == right.getSize() && blocks == pool.getThreadCount());
+
+        // the right hand side of the interface rows needs the neighbours before they get overwritten
+        for (unsigned int k = 0; k < blocks; ++k) {
+            const unsigned int row = begin[k + 1] - 1;
+            couplings[k].rhs = right(Matrix::Upper, row) * vec[row - 1] + right(Matrix::Diagonal, row) * vec[row];
+            if (k + 1 < blocks) {
+                couplings[k].rhs += right(Matrix::Lower, row) * vec[row + 1];
+            }
+        }
+
+        pool.run([&] (unsigned int k) {
+            const unsigned int first = begin[k];
+            const unsigned int last = begin[k + 1] - 2;
+            T previous = first > 0 ? vec[first - 1] : T(0);
+            for (unsigned int i = first; i <= last; ++i) {
+                const T current = vec[i];
+                T rhs = right(Matrix::Diagonal, i) * current + right(Matrix::Lower, i) * vec[i + 1];
+                if (i > 0) {
+                    rhs += right(Matrix::Upper, i) * previous;
+                }
+                vec[i] = (i > first ? rhs - upper[i] * vec[i - 1] : rhs) * pivot[i];
+                previous = current;
+            }
+            for (unsigned int i = last; i-- > first;) {
+                vec[i] -= multiplier[i] * vec[i + 1];
+            }
+        });
+
+        for (unsigned int k = 0; k < blocks; ++k) {
+            const unsigned int row = begin[k + 1] - 1;
+            reducedValues[k] = couplings[k].rhs - couplings[k].upper * vec[row - 1];
+            if (k + 1 < blocks) {
+                reducedValues[k] -= couplings[k].lower * vec[row + 1];
+            }
+        }
+        reducedFactorization.solveInPlace(reducedValues);
+        for (unsigned int k = 0; k < blocks; ++k) {
+            vec[begin[k + 1] - 1] = reducedValues[k];
+        }
+
+        pool.run([&] (unsigned int k) {
+            const unsigned int first = begin[k];
+            const unsigned int last = begin[k + 1] - 2;
+            const T left = k > 0 ? reducedValues[k - 1] : T(0);
+            const T own = reducedValues[k];
+            for (unsigned int i = first; i <= last; ++i) {
+                vec[i] += leftSpike[i] * left + rightSpike[i] * own;
+            }
+        });
+    }
+
+    /**
+     * @brief #getBlockCount Return the number of blocks of the factorization.
+     * @return The number of blocks.
+     */
+    unsigned int getBlockCount() const { return begin.empty() ? 0 : static_cast<unsigned int>(begin.size() - 1); }
+
+    /**
+     * @brief #getSize Return the size of the factorized matrix.
+     * @return The size of the factorized matrix.
+     */
+    unsigned int getSize() const { return size; }
+
+private:
+    struct Coupling {
+        T upper; //! The coupling of the interface row to the interior of its block
+        T lower; //! The coupling of the interface row to the interior of the next block
+        T rhs;   //! The right hand side of the interface row
+    };
+
+    std::vector<T> multiplier;     //! The modified upper diagonal c' of the block interiors
+    std::vector<T> pivot;          //! The inverse of the modified main diagonal of the block interiors
+    std::vector<T> upper;          //! The Upper line of the matrix (a in TridiagonalMatrix::solve)
+    std::vector<T> leftSpike;      //! The interior solution for the coupling to the previous interface row
+    std::vector<T> rightSpike;     //! The interior solution for the coupling to the own interface row
+    std::vector<unsigned int> begin;
+    std::vector<Coupling> couplings;
+    TridiagonalMatrix<T> reduced;  //! The system of the interface rows, only reallocated if the block count changes
+    TridiagonalFactorization<T> reducedFactorization;
+    Vector<T> reducedValues;
+    unsigned int size;
+};
@@ -12,14 +12,16 @@ struct SimulationParameter {
      * @param Dt the time step size.
      * @param Iterations the count of the solving equations.
      * @param AtomCount the count of atoms in the sandbox.
+     * @param Threads the count of threads a solver may use for one simulation.
      */
     SimulationParameter(const double Dx,
                         const double Dt,
                         const double Mass,
                         const unsigned int Iterations,
-                        const unsigned int AtomCount)
+                        const unsigned int AtomCount,
+                        const unsigned int Threads = 1)
         : dx(Dx), dt(Dt), mass(Mass), lambda(dt / (2 * mass * dx * dx)),
-          iterations(Iterations), atomCount(AtomCount) {
+          iterations(Iterations), atomCount(AtomCount), threads(Threads) {
     }
 
     const double dx; //! The delta space
@@ -28,4 +30,5 @@ struct SimulationParameter {
     const double lambda; //! The computed lambda from the dx, dt and the mass parameter
     const unsigned int iterations; //! The iteration count for the simulation
     const unsigned int atomCount; //! The atom count in the simulation
+    const unsigned int threads; //! The thread count for the solver of the simulation
 };
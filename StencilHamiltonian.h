@@ -0,0 +1,143 @@
+#pragma once
+
+#include <assert.h>
+#include <vector>
+#include <complex>
+
+#include "Vector.h"
+#include "TridiagonalMatrix.h"
+
+/**
+ * @brief StencilHamiltonian A compact storage for real symmetric tridiagonal Hamiltonians with a constant
+ *        off diagonal, which is the form of the discretized kinetic energy plus a potential:
+ * \f[
+ *      H_{ii} = h_i \qquad H_{i,i\pm1} = t
+ * \f]
+ * Only the real diagonal \f$ h_i \f$ and the scalar hopping term \f$ t \f$ get stored, which needs a
+ * sixth of the memory of a complex TridiagonalMatrix. The full matrix is only built on request.
+ * The template parameter is the element type of the vectors and matrices the operator works with.
+ */
+template <typename T>
+class StencilHamiltonian
+{
+public:
+    /**
+     * @brief StencilHamiltonian Default constructor for an empty operator.
+     */
+    StencilHamiltonian() : hopping(0) {
+    }
+
+    /**
+     * @brief StencilHamiltonian Construct an operator with a zero diagonal.
+     * @param Size The number of elements along the main diagonal.
+     * @param Hopping The value of all off diagonal elements.
+     */
+    StencilHamiltonian(unsigned int Size, double Hopping) : diagonal(Size, 0.0), hopping(Hopping) {
+    }
+
+    /**
+     * @brief #operator () Access the diagonal element with the given index.
+     * @param i The index on the main diagonal.
+     * @return The diagonal element.
+     */
+    double& operator () (unsigned int i) {
+        assert(i < getSize());
+        return diagonal[i];
+    }
+
+    /**
+     * @brief #operator () Access the diagonal element with the given index.
+     * @param i The index on the main diagonal.
+     * @return The diagonal element.
+     */
+    double operator () (unsigned int i) const {
+        assert(i < getSize());
+        return diagonal[i];
+    }
+
+    /**
+     * @brief #multiply Multiply a Vector with the operator and write the result into an existing Vector.
+     * @param vec The Vector to multiply the operator with.
+     * @param result The Vector to write the result into.
+     * @require Both vectors must have the same size as the operator and must not be the same object.
+     */
+    void multiply(const Vector<T>& vec, Vector<T>& result) const {
+        const unsigned int size = getSize();
+        assert(size == vec.size() && size == result.size() && &vec != &result);
+        result[0] = diagonal[0] * vec[0] + hopping * vec[1];
+        for (unsigned int i = 1; i < size - 1; ++i) {
+            result[i] = diagonal[i] * vec[i] + hopping * (vec[i - 1] + vec[i + 1]);
+        }
+        result[size - 1] = hopping * vec[size - 2] + diagonal[size - 1] * vec[size - 1];
+    }
+
+    /**
+     * @brief #toMatrix Build the full TridiagonalMatrix of the operator.
+     * @return The matrix in a new object.
+     */
+    TridiagonalMatrix<T> toMatrix() const {
+        TridiagonalMatrix<T> mat(getSize());
+        for (unsigned int i = 0; i < getSize(); ++i) {
+            mat(TridiagonalMatrix<T>::Lower, i) = T(hopping);
+            mat(TridiagonalMatrix<T>::Diagonal, i) = T(diagonal[i]);
+            mat(TridiagonalMatrix<T>::Upper, i) = T(hopping);
+        }
+        return mat;
+    }
+
+    /**
+     * @brief #toCrankNicolson Build the Crank Nicolson matrix \f$ 1 + i\lambda s H \f$ inplace.
+     * @param mat The matrix to write into, it gets resized if the size does not match.
+     * @param lambda The \f$ \lambda \f$ of the simulation.
+     * @param sign The sign \f$ s \f$, +1 for the left and -1 for the right matrix.
+     */
+    void toCrankNicolson(TridiagonalMatrix<T>& mat, double lambda, double sign) const {
+        if (mat.getSize() != getSize()) {
+            mat = TridiagonalMatrix<T>(getSize());
+        }
+        const T offDiagonal(0, sign * lambda * hopping);
+        for (unsigned int i = 0; i < getSize(); ++i) {
+            mat(TridiagonalMatrix<T>::Lower, i) = offDiagonal;
+            mat(TridiagonalMatrix<T>::Diagonal, i) = T(1.0, sign * lambda * diagonal[i]);
+            mat(TridiagonalMatrix<T>::Upper, i) = offDiagonal;
+        }
+    }
+
+    /**
+     * @brief #updateCrankNicolsonDiagonal Rewrite only the main diagonal of a Crank Nicolson matrix \f$ 1 + i\lambda s H \f$,
+     *                                     whose constant off diagonals were written by #toCrankNicolson before.
+     * @param mat The matrix to update.
+     * @param lambda The \f$ \lambda \f$ of the simulation.
+     * @param sign The sign \f$ s \f$, +1 for the left and -1 for the right matrix.
+     * @require The matrix must have the size of the operator.
+     */
+    void updateCrankNicolsonDiagonal(TridiagonalMatrix<T>& mat, double lambda, double sign) const {
+        assert(mat.getSize() == getSize());
+        T* line = mat.data(TridiagonalMatrix<T>::Diagonal);
+        for (unsigned int i = 0; i < getSize(); ++i) {
+            line[i] = T(1.0, sign * lambda * diagonal[i]);
+        }
+    }
+
+    /**
+     * @brief #data Return the contiguous storage of the diagonal.
+     * @return A pointer to \f$ h_0 \f$.
+     */
+    const double* data() const { return diagonal.data(); }
+
+    /**
+     * @brief #getHopping Return the value of the off diagonal elements.
+     * @return The hopping term.
+     */
+    double getHopping() const { return hopping; }
+
+    /**
+     * @brief #getSize Return the number of elements along the main diagonal.
+     * @return The size of the operator.
+     */
+    unsigned int getSize() const { return static_cast<unsigned int>(diagonal.size()); }
+
+private:
+    std::vector<double> diagonal;
+    double hopping;
+};
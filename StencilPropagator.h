@@ -0,0 +1,126 @@
+#pragma once
+
+#include <assert.h>
+#include <vector>
+
+#include "Vector.h"
+#include "VectorBatch.h"
+#include "complexkernels.h"
+#include "StencilHamiltonian.h"
+
+/**
+ * @brief StencilPropagator The Crank Nicolson step for a StencilHamiltonian.
+ * The left and right matrices
+ * \f[
+ *      Left := 1 + i\lambda H \qquad Right := 1 - i\lambda H
+ * \f]
+ * never get stored. Their diagonals follow from the diagonal of the operator and their off diagonals
+ * are the constants \f$ \pm i\lambda t \f$, so the Thomas multipliers are \f$ c'_i = i\lambda t \cdot p_i \f$
+ * and the factorization only needs the inverse pivots \f$ p_i \f$ and the multipliers. The sweeps of
+ * std::complex<double> run in the ComplexKernels, see stencilPropagate.
+ * In imaginary time the time step \f$ \Delta t \f$ is replaced by \f$ -i\tau \f$ and the step is the implicit
+ * Euler step \f$ (1 + 2\lambda H)\,x = v \f$. The Crank Nicolson factor \f$ (1 - \lambda E)/(1 + \lambda E) \f$ tends
+ * to \f$ -1 \f$ for the large energies of the grid and would not damp them, the Euler factor \f$ 1/(1 + 2\lambda E) \f$
+ * falls with the energy, so the lowest eigenstate always dominates.
+ */
+template <typename T>
+class StencilPropagator
+{
+public:
+    /**
+     * @brief StencilPropagator Default constructor for an empty propagator.
+     */
+    StencilPropagator() : rate(0), explicitRate(0) {
+    }
+
+    /**
+     * @brief #factorize Compute the inverse pivots of the left matrix. The storage gets reused if the size did not change.
+     * @param hamiltonian The operator to propagate with.
+     * @param Lambda The \f$ \lambda \f$ of the simulation.
+     * @param ImaginaryTime True to factorize \f$ 1 + 2\lambda H \f$ for a step in imaginary time.
+     * @require The operator must have at least two elements along the main diagonal.
+     */
+    void factorize(const StencilHamiltonian<T>& hamiltonian, double Lambda, bool ImaginaryTime = false) {
+        assert(hamiltonian.getSize() > 1);
+        setRate(Lambda, ImaginaryTime);
+        resize(hamiltonian.getSize());
+        stencilFactorize(hamiltonian.data(), rate, hamiltonian.getHopping(), pivot.data(), multiplier.data(), hamiltonian.getSize());
+    }
+
+    /**
+     * @brief #propagate Compute \f$ x = Left^{-1} Right\,v \f$ inplace with the fused right hand side.
+     * @param hamiltonian The operator which was factorized.
+     * @param vec The vector \f$ v \f$ which gets replaced by \f$ x \f$.
+     * @require The vector must have the same size as the factorized operator.
+     */
+    void propagate(const StencilHamiltonian<T>& hamiltonian, Vector<T>& vec) const {
+        assert(hamiltonian.getSize() == vec.size() && hamiltonian.getSize() == pivot.size());
+        stencilPropagate(hamiltonian.data(), explicitRate, hamiltonian.getHopping(), pivot.data(), multiplier.data(), vec.data(), vec.size());
+    }
+
+    /**
+     * @brief #factorizeAndPropagate Factorize the left matrix within the forward substitution of #propagate.
+     *                               This is meant for operators whose diagonal changes every step.
+     * @param hamiltonian The operator to propagate with.
+     * @param Lambda The \f$ \lambda \f$ of the simulation.
+     * @param vec The vector \f$ v \f$ which gets replaced by \f$ x \f$.
+     * @param ImaginaryTime True for a step in imaginary time, see #factorize.
+     * @require The vector must have the same size as the operator.
+     */
+    void factorizeAndPropagate(const StencilHamiltonian<T>& hamiltonian, double Lambda, Vector<T>& vec, bool ImaginaryTime = false) {
+        assert(hamiltonian.getSize() == vec.size() && vec.size() > 1);
+        setRate(Lambda, ImaginaryTime);
+        resize(vec.size());
+        stencilFactorizeAndPropagate(hamiltonian.data(), rate, explicitRate, hamiltonian.getHopping(),
+                                     pivot.data(), multiplier.data(), vec.data(), vec.size());
+    }
+
+    /**
+     * @brief #propagate Compute \f$ x = Left^{-1} Right\,v \f$ inplace for every member of the batch.
+     * @param hamiltonian The operator which was factorized.
+     * @param batch The members \f$ v \f$ which get replaced by their \f$ x \f$.
+     * @param previous A buffer with one element per member of the batch.
+     * @require The members must have the same size as the factorized operator.
+     */
+    void propagate(const StencilHamiltonian<T>& hamiltonian, VectorBatch<T>& batch, Vector<T>& previous) const {
+        const unsigned int size = hamiltonian.getSize();
+        const unsigned int members = batch.getMemberCount();
+        assert(size == batch.size() && size == pivot.size() && members <= previous.size());
+        const T coupling = rate * hamiltonian.getHopping();
+        const T explicitCoupling = explicitRate * hamiltonian.getHopping();
+
+        batchForwardRow(T(0), T(1) - explicitRate * hamiltonian(0), -explicitCoupling, T(0), pivot[0],
+                        previous.data(), batch.row(0), batch.row(0), batch.row(1), members);
+        for (unsigned int i = 1; i < size; ++i) {
+            const bool inner = i + 1 < size;
+            batchForwardRow(-explicitCoupling, T(1) - explicitRate * hamiltonian(i), inner ? -explicitCoupling : T(0), coupling, pivot[i],
+                            previous.data(), batch.row(i), batch.row(i - 1), inner ? batch.row(i + 1) : batch.row(i), members);
+        }
+
+        for (unsigned int i = size - 1; i-- > 0;) {
+            batchBackwardRow(multiplier[i], batch.row(i), batch.row(i + 1), members);
+        }
+    }
+
+    /**
+     * @brief #getSize Return the size of the factorized operator.
+     * @return The size of the factorized operator.
+     */
+    unsigned int getSize() const { return static_cast<unsigned int>(pivot.size()); }
+
+private:
+    void setRate(double Lambda, bool ImaginaryTime) {
+        rate = ImaginaryTime ? T(2 * Lambda) : T(0, Lambda);
+        explicitRate = ImaginaryTime ? T(0) : rate;
+    }
+
+    void resize(unsigned int size) {
+        pivot.resize(size);
+        multiplier.resize(size);
+    }
+
+    std::vector<T> pivot;      //! The inverse of the modified main diagonal of the left matrix
+    std::vector<T> multiplier; //! The Thomas multipliers \f$ c'_i \f$ of the left matrix
+    T rate;               //! The factor \f$ i\lambda \f$ of the operator in the left matrix, \f$ 2\lambda \f$ in imaginary time
+    T explicitRate;       //! The factor of the operator in the right matrix, zero in imaginary time
+};
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <assert.h>
+#include <vector>
+
+#include "Vector.h"
+#include "VectorBatch.h"
+#include "complexkernels.h"
+#include "TridiagonalMatrix.h"
+
+/**
+ * @brief TridiagonalFactorization The precomputed forward elimination of the Thomas algorithm
+ *        for a TridiagonalMatrix.
+ * TridiagonalMatrix::solve recomputes the modified coefficients on every call. If the matrix
+ * stays the same for many right hand sides (e.g. the left matrix of the Crank Nicolson scheme)
+ * the elimination only needs to be done once and every solve is reduced to the substitution:
+ * \f[
+ *      d'_i = (d_i - a_i d'_{i-1}) \cdot p_i \qquad x_i = d'_i - c'_i x_{i+1}
+ * \f]
+ * with the inverse pivots \f$ p_i \f$ and the multipliers \f$ c'_i \f$ (naming as in TridiagonalMatrix::solve).
+ */
+template <typename T>
+class TridiagonalFactorization
+{
+public:
+    /**
+     * @brief TridiagonalFactorization Default constructor for an empty factorization.
+     */
+    TridiagonalFactorization() : size(0) {
+    }
+
+    /**
+     * @brief TridiagonalFactorization Factorize the given matrix.
+     * @param mat The matrix to factorize.
+     */
+    TridiagonalFactorization(const TridiagonalMatrix<T>& mat) : size(0) {
+        factorize(mat);
+    }
+
+    /**
+     * @brief #factorize Compute the multipliers and the inverse pivots of the given matrix.
+     *                   The storage gets reused if the size did not change.
+     * @param mat The matrix to factorize.
+     * @require The matrix must have at least two elements along the main diagonal.
+     */
+    void factorize(const TridiagonalMatrix<T>& mat) {
+        typedef TridiagonalMatrix<T> Matrix;
+        assert(mat.getSize() > 1);
+        size = mat.getSize();
+        multiplier.resize(size);
+        pivot.resize(size);
+        upper.resize(size);
+
+        pivot[0] = T(1) / mat(Matrix::Diagonal, 0);
+        multiplier[0] = mat(Matrix::Lower, 0) * pivot[0];
+        upper[0] = mat(Matrix::Upper, 0);
+        for (unsigned int i = 1; i < size; ++i) {
+            upper[i] = mat(Matrix::Upper, i);
+            pivot[i] = T(1) / (mat(Matrix::Diagonal, i) - upper[i] * multiplier[i - 1]);
+            multiplier[i] = mat(Matrix::Lower, i) * pivot[i];
+        }
+    }
+
+    /**
+     * @brief #solve Solve the factorized system for the given vector.
+     * @param vec The resulting vector (the b vector in \f$ Ax = b \f$).
+     * @require The vector must have the same size as the factorized matrix.
+     * @return The x vector of the system.
+     */
+    Vector<T> solve(const Vector<T>& vec) const {
+        Vector<T> x(vec);
+        solveInPlace(x);
+        return x;
+    }
+
+    /**
+     * @brief #solveInPlace Solve the factorized system and overwrite the given vector with the solution.
+     * @param vec The b vector of the system which gets replaced by the x vector.
+     * @require The vector must have the same size as the factorized matrix.
+     */
+    void solveInPlace(Vector<T>& vec) const {
+        assert(size == vec.size());
+        vec[0] *= pivot[0];
+        for (unsigned int i = 1; i < size; ++i) {
+            vec[i] = (vec[i] - upper[i] * vec[i - 1]) * pivot[i];
+        }
+        for (unsigned int i = size - 1; i-- > 0;) {
+            vec[i] -= multiplier[i] * vec[i + 1];
+        }
+    }
+
+    /**
+     * @brief #propagate Compute \f$ x = A^{-1} R v \f$ inplace for the factorized matrix \f$ A \f$.
+     *                   The product with \f$ R \f$ gets evaluated inside the forward substitution,
+     *                   so the vector is only streamed once forward and once backward.
+     * @param right The matrix \f$ R \f$ to multiply the vector with before solving.
+     * @param vec The vector \f$ v \f$ which gets replaced by \f$ x \f$.
+     * @require The matrix and the vector must have the same size as the factorized matrix.
+     */
+    void propagate(const TridiagonalMatrix<T>& right, Vector<T>& vec) const {
+        typedef TridiagonalMatrix<T> Matrix;
+        assert(size == vec.size() && size == right.getSize());
+        T previous = vec[0];
+        T current = vec[0];
+        vec[0] = (right(Matrix::Diagonal, 0) * current + right(Matrix::Lower, 0) * vec[1]) * pivot[0];
+        for (unsigned int i = 1; i < size - 1; ++i) {
+            current = vec[i];
+            const T rhs = right(Matrix::Upper, i) * previous +
+                          right(Matrix::Diagonal, i) * current +
+                          right(Matrix::Lower, i) * vec[i + 1];
+            vec[i] = (rhs - upper[i] * vec[i - 1]) * pivot[i];
+            previous = current;
+        }
+        const T rhs = right(Matrix::Upper, size - 1) * previous + right(Matrix::Diagonal, size - 1) * vec[size - 1];
+        vec[size - 1] = (rhs - upper[size - 1] * vec[size - 2]) * pivot[size - 1];
+
+        for (unsigned int i = size - 1; i-- > 0;) {
+            vec[i] -= multiplier[i] * vec[i + 1];
+        }
+    }
+
+    /**
+     * @brief #propagate Compute \f$ x = A^{-1} R v \f$ inplace for every member of the batch.
+     *                   The factorization and the matrix entries of a row get loaded once for all members.
+     * @param right The matrix \f$ R \f$ to multiply the members with before solving.
+     * @param batch The members \f$ v \f$ which get replaced by their \f$ x \f$.
+     * @param previous A buffer with one element per member of the batch.
+     * @require The matrix and the members must have the same size as the factorized matrix.
+     */
+    void propagate(const TridiagonalMatrix<T>& right, VectorBatch<T>& batch, Vector<T>& previous) const {
+        typedef TridiagonalMatrix<T> Matrix;
+        const unsigned int members = batch.getMemberCount();
+        assert(size == batch.size() && size == right.getSize() && members <= previous.size());
+
+        // the first row has no previous row, so it gets coupled to itself with zero weights
+        batchForwardRow(T(0), right(Matrix::Diagonal, 0), right(Matrix::Lower, 0), T(0), pivot[0],
+                   previous.data(), batch.row(0), batch.row(0), batch.row(1), members);
+        for (unsigned int i = 1; i < size; ++i) {
+            const bool inner = i + 1 < size;
+            batchForwardRow(right(Matrix::Upper, i), right(Matrix::Diagonal, i), inner ? right(Matrix::Lower, i) : T(0), upper[i], pivot[i],
+                       previous.data(), batch.row(i), batch.row(i - 1), inner ? batch.row(i + 1) : batch.row(i), members);
+        }
+
+        for (unsigned int i = size - 1; i-- > 0;) {
+            batchBackwardRow(multiplier[i], batch.row(i), batch.row(i + 1), members);
+        }
+    }
+
+    /**
+     * @brief #getSize Return the size of the factorized matrix.
+     * @return The size of the factorized matrix.
+     */
+    unsigned int getSize() const { return size; }
+
+private:
+    std::vector<T> multiplier; //! The modified upper diagonal c'
+    std::vector<T> pivot;      //! The inverse of the modified main diagonal
+    std::vector<T> upper;      //! The Upper line of the matrix (a in TridiagonalMatrix::solve)
+    unsigned int size;
+};
@@ -11,6 +11,8 @@
 
 #include "Vector.h"
 #include "utilitys.h"
+#include "complexkernels.h"
+#include "tridiagonaleigensolver.h"
 
 /**
  * @brief TridiagonalMatrix Tridiagonal matrix storage for compression.
@@ -177,6 +179,20 @@ public:
     template <typename U>
     friend Vector<U> operator * (const Vector<U>& other, const TridiagonalMatrix<U>& mat);
 
+    /**
+     * @brief #multiply Multiply a Vector with the current TridiagonalMatrix like the operator *,
+     *                  but write the result into an existing Vector instead of a new object.
+     * @param vec The Vector to multiply the matrix with.
+     * @param result The Vector to write the result into.
+     * @require Both vectors must have the same size as the matrix and must not be the same object.
+     */
+    void multiply(const Vector<T>& vec, Vector<T>& result) const {
+        assert(size == vec.size() && size == result.size() && &vec != &result);
+        result[0] = mat[Diagonal][0] * vec[0] + mat[Lower][0] * vec[1];
+        multiplyRows(mat[Upper].data(), mat[Diagonal].data(), mat[Lower].data(), vec.data(), result.data(), size);
+        result[size - 1] = mat[Upper][size - 1] * vec[size - 2] + mat[Diagonal][size - 1] * vec[size - 1];
+    }
+
     /**
      * @brief #operator () The index operator to access elements by the diagonal and the index.
      * @param line The diagonal of the element.
@@ -219,7 +235,7 @@ public:
         auto a = mat[Upper];
 
 
-        c[0] /= c[0];
+        c[0] /= b[0];
         d[0] /= b[0];
         for (unsigned int i = 1; i < size - 1; ++i) {
             c[i] /= b[i] - a[i] * c[i - 1];
@@ -234,55 +250,48 @@ public:
     }
 
     /**
-     * @brief #getEigenvalues Return the eigenvalues of the Matrix in accending order.
-     * @param error The error value for the non diagonal elements. For smaller errors use a smaller error value.
-     * @return The Eigenvalues organised in a std::vector<T>.
-     * @note The used algorithm is the qr algorithm for symmetric tridiagonal matrices so be carefull if your not using symmetric matrices.
+     * @brief #getEigensolver Return an eigensolver for the real symmetric matrix with the same eigenvalues.
+     *        The diagonal is the real part of the main diagonal and the off diagonal elements are
+     *        \f$ \sqrt{|b_i c_{i+1}|} \f$, which keeps the spectrum of symmetric and of symmetrizable matrices.
+     * @return The eigensolver of the matrix.
      */
-    template <typename U>
-    typename std::enable_if<!std::is_complex<U>::value, Vector<U>>::type getEigenvalues(U error = 0.00001) {
-        TridiagonalMatrix<U> step(*this);
-        step.qrStep(std::sqrt(step.getSize()));
-
-        std::vector<U> eigenvalues;
-        eigenvalues.resize(size);
+    TridiagonalEigensolver getEigensolver() const {
+        std::vector<double> diagonal(size);
+        std::vector<double> offDiagonal(size, 0.0);
         for (unsigned int i = 0; i < size; ++i) {
-            eigenvalues[i] = step(Diagonal, i);
+            diagonal[i] = std::real(mat[Diagonal][i]);
         }
-        std::sort(eigenvalues.begin(), eigenvalues.end());
-        Vector<U> result(eigenvalues.size());
-        for (unsigned int i = 0; i < eigenvalues.size(); ++i) {
-            result(i) = eigenvalues[i];
+        for (unsigned int i = 0; i + 1 < size; ++i) {
+            offDiagonal[i] = std::sqrt(std::abs(mat[Lower][i] * mat[Upper][i + 1]));
         }
-
-        return result;
+        return TridiagonalEigensolver(diagonal, offDiagonal);
     }
 
     /**
      * @brief #getEigenvalues Return the eigenvalues of the Matrix in accending order.
-     * @param error The error value for the non diagonal elements. For smaller errors use a smaller error value.
-     * @return The Eigenvalues organised in a std::vector<T>
-     * @note The used algorithm is the qr algorithm for symmetric tridiagonal matrices so be carefull if your not using symmetric matrices.
+     * @return The Eigenvalues organised in a Vector<U>.
+     * @note The matrix gets treated as a symmetric matrix, see #getEigensolver.
      */
     template <typename U>
-    typename std::enable_if<std::is_complex<U>::value, Vector<typename U::value_type>>::type getEigenvalues(typename U::value_type error = typename U::value_type(0.00001)) {
-        TridiagonalMatrix<U> step(*this);
-        step.qrStep(std::sqrt(step.getSize()));
-
-        std::vector<typename U::value_type> eigenvalues;
-        eigenvalues.resize(size);
-        for (unsigned int i = 0; i < size; ++i) {
-            eigenvalues[i] = step(Diagonal, i).real();
-        }
-        std::sort(eigenvalues.begin(), eigenvalues.end());
-        Vector<typename U::value_type> result(eigenvalues.size());
+    typename std::enable_if<!std::is_complex<U>::value, Vector<U>>::type getEigenvalues() const {
+        const std::vector<double> eigenvalues = getEigensolver().eigenvalues();
+        Vector<U> result(eigenvalues.size());
         for (unsigned int i = 0; i < eigenvalues.size(); ++i) {
             result(i) = eigenvalues[i];
         }
-
         return result;
     }
 
+    /**
+     * @brief #getEigenvalues Return the real eigenvalues of the Matrix in accending order.
+     * @return The Eigenvalues organised in a Vector<U::value_type>.
+     * @note The matrix gets treated as a symmetric matrix, see #getEigensolver.
+     */
+    template <typename U>
+    typename std::enable_if<std::is_complex<U>::value, Vector<typename U::value_type>>::type getEigenvalues() const {
+        return getEigenvalues<typename U::value_type>();
+    }
+
     /**
      * @brief #getExpectationValue computes the expectation value of an operator:
      *        \f[
@@ -296,6 +305,20 @@ public:
         return vec.dot(result);
     }
 
+    /**
+     * @brief #data Return the elements of a line as contiguous memory.
+     * @param line The line of the matrix.
+     * @return A pointer to getSize() elements of the line.
+     */
+    T* data(Line line) { return mat[line].data(); }
+
+    /**
+     * @brief #data Return the elements of a line as contiguous memory.
+     * @param line The line of the matrix.
+     * @return A pointer to getSize() elements of the line.
+     */
+    const T* data(Line line) const { return mat[line].data(); }
+
     /**
      * @brief #getSize Return the size of the matrix elements.
      *                This is equal to the number of elements along the main diagonal.
@@ -305,139 +328,17 @@ public:
 
 private:
     template <typename U>
-    typename std::enable_if<!std::is_complex<U>::value, U>::type sign (U x) {
-        U value;
-        if (x < 0.0) {
-            value = -1.0;
-        }
-        else {
-            value = 1.0;
-        }
-        return value;
-    }
-
-    template <typename U>
-    typename std::enable_if<std::is_complex<T>::value, U>::type sign (U x) {
-        U value;
-        if (x.real() < 0.0) {
-            value = -1.0;
-        }
-        else {
-            value = 1.0;
+    static void multiplyRows(const U* upper, const U* diagonal, const U* lower, const U* x, U* result, unsigned int size) {
+        for (unsigned int i = 1; i < size - 1; ++i) {
+            result[i] = upper[i] * x[i - 1] + diagonal[i] * x[i] + lower[i] * x[i + 1];
         }
-        return value;
     }
 
-    inline std::tuple<T, T, T> givens(T a, T b) {
-        std::tuple<T, T, T> result;
-        if (std::abs(b) <= std::abs(std::numeric_limits<T>::epsilon())) {
-            std::get<0>(result) = sign(a); //std::copysign(1.0, a); // c
-            std::get<1>(result) = 0;                  // s
-            std::get<2>(result) = std::abs(a);        // r
-        } else if (std::abs(a) <= std::abs(std::numeric_limits<T>::epsilon())) {
-            std::get<0>(result) = 0;
-            std::get<1>(result) = sign(b); //std::copysign(1.0, b);
-            std::get<2>(result) = std::abs(b);
-        } else if (std::abs(b) > std::abs(a)) {
-            const T t = a / b;
-            const T u = sign(b) * std::sqrt(T(1) + t * t); //std::copysign(std::sqrt(1.0 + t*t), b);
-            std::get<1>(result) = -1.0 / u;
-            std::get<0>(result) = -std::get<1>(result) * t;
-            std::get<2>(result) = b * u;
-        } else {
-            const T t = b / a;
-            const T u = sign(a) * std::sqrt(T(1) + t * t); //std::copysign(std::sqrt(T(1) + t*t), a);
-            std::get<0>(result) = 1.0 / u;
-            std::get<1>(result) = -std::get<0>(result) * t;
-            std::get<2>(result) = a * u;
-        }
-        return result;
+    static void multiplyRows(const std::complex<double>* upper, const std::complex<double>* diagonal, const std::complex<double>* lower,
+                             const std::complex<double>* x, std::complex<double>* result, unsigned int size) {
+        ComplexKernels::get().multiply(upper, diagonal, lower, x, result, size);
     }
 
-    void qrStep(unsigned int iterations) {
-        unsigned int m = (*this).getSize() - 1;
-        unsigned int k = iterations;
-        while (m > 1) {
-            T shift = (*this)(Diagonal, m);
-            const T u = ((*this)(Diagonal, m - 1) - (*this)(Diagonal, m)) / 2.0;
-            if (std::abs(u) <= std::abs(std::numeric_limits<T>::epsilon())) {
-                shift = (*this)(Diagonal, m) - std::abs((*this)(Upper, m));
-            } else {
-                T b = (*this)(Upper, m - 1);
-                shift = (*this)(Diagonal, m) - sign(u) * b * b / (std::abs(u) + std::sqrt(u * u + b * b));
-            }
-
-            T x = (*this)(Diagonal, 0) - shift;
-            T y = (*this)(Upper, 0);
-            for (unsigned int k = 0; k < m; ++k) {
-                std::tuple<T, T, T> giv = givens(x, y);
-                const T c = std::get<0>(giv);
-                const T s = std::get<1>(giv);
-
-                const T w = c * x - s * y;
-                const T d = (*this)(Diagonal, k) - (*this)(Diagonal, k + 1);
-                const T z = (2 * c * (*this)(Upper, k) + d * s) * s;
-                (*this)(Diagonal, k) -= z;
-                (*this)(Diagonal, k + 1) += z;
-                (*this)(Upper, k) = d * c * s + (c * c - s * s) * (*this)(Upper, k);
-                x = (*this)(Upper, k);
-                if (k > 0) {
-                    (*this)(Upper, k - 1) = w;
-                }
-                if (k < m - 1) {
-                    y = -s * (*this)(Upper, k + 1);
-                    (*this)(Upper, k + 1) *= c;
-                }
-            }
-
-            k--;
-            if (k == 0) {
-                m--;
-                k = iterations;
-            }
-        }
-
-    }
-
-    /*void qrStep(unsigned int M, unsigned int s) {
-        assert (s > 1 && s <= size);
-
-        T shift = (*this)(Diagonal, M); //0.0;
-        //Wilkinson shift
-        const T u = ((*this)(Diagonal, M - 1) - (*this)(Diagonal, M)) / 2.0;
-        if (std::abs(u) <= std::abs(std::numeric_limits<T>::epsilon())) {
-            shift = (*this)(Diagonal, M) - std::abs((*this)(Upper, M));
-        } else {
-            T b = (*this)(Upper, M - 1);
-            shift = (*this)(Diagonal, M) - sign(u) * b * b / (std::abs(u) + std::sqrt(u * u + b * b));
-        }
-
-        const unsigned int size = s; //(*this).getSize();
-        T a = (*this)(Diagonal, 0) - shift;
-        T b = (*this)(Upper, 0);
-        T x = (*this)(Diagonal, 0);
-        T y = (*this)(Upper, 0);
-        for (unsigned int i = 0; i < size - 1; ++i) {
-            std::tuple<T, T, T> giv = givens(a, b);
-            const T c = std::get<0>(giv);
-            const T s = std::get<1>(giv);
-            const T r = std::get<2>(giv);
-            (*this)(Diagonal, i) = c * c * x + T(2) * c * s * y + s * s * (*this)(Diagonal, i + 1);
-            a = (c * c - s * s) * y + c * s * ((*this)(Diagonal, i + 1) - x);
-            x = s * s * x - T(2) * c * s * y + c * c * (*this)(Diagonal, i + 1);
-
-            if (i > 0) {
-                (*this)(Upper, i - 1) = r;
-            }
-            if (i < size - 1) {
-                b = s * (*this)(Upper, i + 1);
-                y = c * (*this)(Upper, i + 1);
-            }
-        }
-        (*this)(Upper, size - 2) = a;
-        (*this)(Diagonal, size - 1) = x;
-    }*/
-
     std::vector<T> mat[3];
     unsigned int size;
 };
@@ -446,14 +347,7 @@ private:
 template <typename T>
 inline Vector<T> operator * (const TridiagonalMatrix<T>& mat, const Vector<T>& other) {
     Vector<T> r(mat.size);
-    r(0) = mat.mat[TridiagonalMatrix<T>::Diagonal][0] * other(0) + mat.mat[TridiagonalMatrix<T>::Lower][0] * other(1);
-    for (unsigned int i = 1; i < mat.size - 1; ++i) {
-        r(i) = mat.mat[TridiagonalMatrix<T>::Upper][i] * other(i - 1) +
-               mat.mat[TridiagonalMatrix<T>::Diagonal][i] * other(i)  +
-               mat.mat[TridiagonalMatrix<T>::Lower][i] * other(i + 1);
-    }
-    r(mat.size - 1) = mat.mat[TridiagonalMatrix<T>::Upper][mat.size - 1] * other(mat.size - 2) +
-                      mat.mat[TridiagonalMatrix<T>::Diagonal][mat.size - 1] * other(mat.size - 1);
+    mat.multiply(other, r);
     return r;
 }
 
@@ -3,11 +3,13 @@
 
 
 #include <vector>
+#include <utility>
 #include <stdlib.h>
 #include <type_traits>
 
 #include "assert.h"
 #include "utilitys.h"
+#include "complexkernels.h"
 
 
 /**
@@ -139,12 +141,7 @@ public:
      */
     T dot(const Vector<T>& other) const {
         assert(size() == other.size());
-        T ret = T();
-        Vector<T> conj = this->conjungate<T>();
-        for (unsigned int i = 0; i < size(); ++i) {            
-            ret += conj(i) * other(i);
-        }
-        return ret;
+        return dotValues(values.data(), other.values.data(), size());
     }
 
     /**
@@ -199,6 +196,22 @@ public:
         return sqrt(val);
     }
 
+    /**
+     * @brief #squaredNorm Compute the squared euclidian norm \f$ \sum_i |x_i|^2 \f$ without a complex dot product.
+     * @return The squared norm.
+     */
+    double squaredNorm() const {
+        return squaredNormValues(values.data(), size());
+    }
+
+    /**
+     * @brief #scale Multiply all elements with a real factor inplace, e.g. to renormalize a state.
+     * @param factor The factor.
+     */
+    void scale(double factor) {
+        scaleValues(values.data(), factor, size());
+    }
+
     /**
      * @brief #normalised Compute the normalized vector by euclidian norm.
      * @return the normalized vector.
@@ -207,6 +220,27 @@ public:
         return (*this) * (T(1) / length());
     }
 
+    /**
+     * @brief #data Return the contiguous storage of the elements.
+     * @return A pointer to the first element.
+     */
+    T* data() { return values.data(); }
+
+    /**
+     * @brief #data Return the contiguous storage of the elements.
+     * @return A pointer to the first element.
+     */
+    const T* data() const { return values.data(); }
+
+    /**
+     * @brief #swap Exchange the elements with another vector without copying them.
+     * @param other The vector to exchange the elements with.
+     */
+    void swap(Vector& other) {
+        values.swap(other.values);
+        std::swap(si, other.si);
+    }
+
     /**
      * @brief #size return the element count in the vector.
      * @return the element count in the vector.
@@ -214,6 +248,53 @@ public:
     unsigned int size() const { return si; }
 
 private:
+    template <typename U>
+    static typename std::enable_if<std::is_complex<U>::value, U>::type conjungateValue(const U& value) {
+        return std::conj(value);
+    }
+
+    template <typename U>
+    static typename std::enable_if<!std::is_complex<U>::value, U>::type conjungateValue(const U& value) {
+        return value;
+    }
+
+    template <typename U>
+    static U dotValues(const U* a, const U* b, unsigned int size) {
+        U ret = U();
+        for (unsigned int i = 0; i < size; ++i) {
+            ret += conjungateValue<U>(a[i]) * b[i];
+        }
+        return ret;
+    }
+
+    static std::complex<double> dotValues(const std::complex<double>* a, const std::complex<double>* b, unsigned int size) {
+        return ComplexKernels::get().dot(a, b, size);
+    }
+
+    template <typename U>
+    static double squaredNormValues(const U* a, unsigned int size) {
+        double ret = 0;
+        for (unsigned int i = 0; i < size; ++i) {
+            ret += std::norm(a[i]);
+        }
+        return ret;
+    }
+
+    static double squaredNormValues(const std::complex<double>* a, unsigned int size) {
+        return ComplexKernels::get().squaredNorm(a, size);
+    }
+
+    template <typename U>
+    static void scaleValues(U* a, double factor, unsigned int size) {
+        for (unsigned int i = 0; i < size; ++i) {
+            a[i] *= factor;
+        }
+    }
+
+    static void scaleValues(std::complex<double>* a, double factor, unsigned int size) {
+        ComplexKernels::get().scale(a, factor, size);
+    }
+
     std::vector<T> values;
     unsigned int si;
 };
@@ -0,0 +1,119 @@
+#ifndef VECTORBATCH_H
+#define VECTORBATCH_H
+
+#include <vector>
+#include <assert.h>
+
+#include "Vector.h"
+
+/**
+ * @brief VectorBatch
+ * A block of equally sized vectors which get processed together. The elements of all members
+ * with the same index are stored next to each other, so a loop over the members of one row
+ * runs over contiguous memory and can be vectorized.
+ */
+template <typename T>
+class VectorBatch {
+public:
+    /**
+     * @brief VectorBatch default constructor with no elements and no members.
+     */
+    VectorBatch() : si(0), members(0) {
+    }
+
+    /**
+     * @brief VectorBatch Constructs a new batch with initial values set to zero.
+     * @param Size The dimension of every member.
+     * @param Members The count of vectors in the batch.
+     */
+    VectorBatch(unsigned int Size, unsigned int Members) : si(Size), members(Members) {
+        values.resize(static_cast<size_t>(si) * members, T(0.0));
+    }
+
+    /**
+     * @brief #operator () Index operator to access elements by index and member.
+     * @param i The index of the element.
+     * @param member The member of the batch.
+     * @return The element of the member at the index.
+     */
+    T& operator () (unsigned int i, unsigned int member) {
+        assert(i < size() && member < getMemberCount());
+        return values[static_cast<size_t>(i) * members + member];
+    }
+
+    /**
+     * @brief #operator () Index operator to access elements by index and member.
+     * @param i The index of the element.
+     * @param member The member of the batch.
+     * @return The element of the member at the index.
+     */
+    T operator () (unsigned int i, unsigned int member) const {
+        assert(i < size() && member < getMemberCount());
+        return values[static_cast<size_t>(i) * members + member];
+    }
+
+    /**
+     * @brief #row Return the elements of all members at the given index.
+     * @param i The index of the elements.
+     * @return A pointer to getMemberCount() contiguous elements.
+     */
+    T* row(unsigned int i) {
+        assert(i < size());
+        return values.data() + static_cast<size_t>(i) * members;
+    }
+
+    /**
+     * @brief #row Return the elements of all members at the given index.
+     * @param i The index of the elements.
+     * @return A pointer to getMemberCount() contiguous elements.
+     */
+    const T* row(unsigned int i) const {
+        assert(i < size());
+        return values.data() + static_cast<size_t>(i) * members;
+    }
+
+    /**
+     * @brief #getMember Copy a member of the batch into a vector.
+     * @param member The member to copy.
+     * @param vec The vector to write the elements into.
+     * @require The vector must have the same size as the members of the batch.
+     */
+    void getMember(unsigned int member, Vector<T>& vec) const {
+        assert(vec.size() == size() && member < getMemberCount());
+        for (unsigned int i = 0; i < size(); ++i) {
+            vec[i] = (*this)(i, member);
+        }
+    }
+
+    /**
+     * @brief #setMember Copy a vector into a member of the batch.
+     * @param member The member to overwrite.
+     * @param vec The vector with the new elements.
+     * @require The vector must have the same size as the members of the batch.
+     */
+    void setMember(unsigned int member, const Vector<T>& vec) {
+        assert(vec.size() == size() && member < getMemberCount());
+        for (unsigned int i = 0; i < size(); ++i) {
+            (*this)(i, member) = vec[i];
+        }
+    }
+
+    /**
+     * @brief #size return the element count of every member.
+     * @return the element count of every member.
+     */
+    unsigned int size() const { return si; }
+
+    /**
+     * @brief #getMemberCount return the count of vectors in the batch.
+     * @return the count of vectors in the batch.
+     */
+    unsigned int getMemberCount() const { return members; }
+
+private:
+    std::vector<T> values;
+    unsigned int si;
+    unsigned int members;
+};
+
+#endif // VECTORBATCH_H
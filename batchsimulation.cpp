@@ -0,0 +1,83 @@
+#include "batchsimulation.h"
+
+#include <assert.h>
+
+#include "profiler.h"
+
+BatchSimulation::BatchSimulation(SimulationParameter params, std::shared_ptr<ComplexHamiltonianSolver> hamiltonian, unsigned int count) {
+    for (unsigned int i = 0; i < count; ++i) {
+        members.push_back(std::make_shared<Simulation>(params, hamiltonian));
+    }
+}
+
+BatchSimulation::BatchSimulation(std::vector<std::shared_ptr<Simulation>> Members)
+    : members(Members) {
+}
+
+void BatchSimulation::run() {
+    assert(!members.empty());
+    Simulation& first = *members.front();
+    const SimulationParameter parameter = first.getParameter();
+
+    atoms = ComplexVectorBatch(parameter.atomCount, getMemberCount());
+    for (unsigned int j = 0; j < getMemberCount(); ++j) {
+        atoms.setMember(j, members[j]->atoms);
+    }
+
+    ProfileScope runScope(Profiler::SimulationRun);
+    notify(Observable::Startup);
+
+    ComplexHamiltonianSolver::Workspace workspace(parameter.atomCount, getMemberCount());
+    workspace.pool = first.pool.get();
+    const uint64_t start = Profiler::isEnabled() ? Profiler::now() : 0;
+    {
+        ProfileScope loopScope(Profiler::SimulationLoop);
+        for (unsigned int i = 0; i < parameter.iterations; ++i) {
+            {
+                ProfileScope scope(Profiler::SolverStep);
+                first.hamiltonian->step(atoms, workspace);
+            }
+            {
+                ProfileScope scope(Profiler::Boundary);
+                for (unsigned int j = 0; j < getMemberCount(); ++j) {
+                    atoms(0, j) = atoms(atoms.size() - 1, j) = 0;
+                }
+            }
+
+            notify(Observable::Iteration);
+            for (auto& it : members) {
+                it->currentIteration++;
+            }
+        }
+    }
+    if (start != 0) {
+        // every member advances one step per iteration
+        Profiler::get().addSteps(static_cast<uint64_t>(parameter.iterations) * getMemberCount(), Profiler::now() - start);
+    }
+
+    notify(Observable::Cooldown);
+}
+
+Simulation& BatchSimulation::getMember(unsigned int member) {
+    assert(member < members.size());
+    return *members[member];
+}
+
+unsigned int BatchSimulation::getMemberCount() const {
+    return static_cast<unsigned int>(members.size());
+}
+
+void BatchSimulation::notify(Observable::CheckTime time) {
+    for (unsigned int j = 0; j < getMemberCount(); ++j) {
+        Simulation& member = *members[j];
+        bool observed = false;
+        for (auto& it : member.filter) {
+            observed = observed || it->check(time, member.currentIteration, member.parameter.dt);
+        }
+
+        if (observed) {
+            atoms.getMember(j, member.atoms);
+            member.notify(time);
+        }
+    }
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+
+#include "VectorBatch.h"
+#include "simulation.h"
+
+typedef VectorBatch<std::complex<double>> ComplexVectorBatch;
+
+/**
+ * @brief The BatchSimulation class propagates multiple simulations with the same parameter and solver together.
+ *        The states of all members get stored interleaved in one ComplexVectorBatch, so every step
+ *        shares the matrices (and for linear solvers the factorization) between all members.
+ *        Every member is a Simulation on its own which holds the waves and the observables of the member.
+ *        Before an observable of a member gets called, the state of the member gets copied into it.
+ */
+class BatchSimulation
+{
+public:
+    /**
+     * @brief BatchSimulation Construct a batch of new simulations.
+     * @param params The simulation parameter of all members.
+     * @param hamiltonian The solver which solves the Schrödinger equation for all members.
+     * @param members The count of simulations in the batch.
+     */
+    BatchSimulation(SimulationParameter params, std::shared_ptr<ComplexHamiltonianSolver> hamiltonian, unsigned int members);
+
+    /**
+     * @brief BatchSimulation Construct a batch of existing simulations.
+     *        The parameter and the solver of the first simulation get used for all members.
+     * @param members The simulations in the batch.
+     */
+    BatchSimulation(std::vector<std::shared_ptr<Simulation>> members);
+
+    /**
+     * @brief #run Runs all simulations of the batch and call the filter methods of their observables.
+     */
+    void run();
+
+    /**
+     * @brief #getMember Return a simulation of the batch to add waves and observables to it.
+     * @param member The index of the simulation.
+     * @return The simulation.
+     */
+    Simulation& getMember(unsigned int member);
+
+    /**
+     * @brief #getMemberCount Return the count of simulations in the batch.
+     * @return The count of simulations.
+     */
+    unsigned int getMemberCount() const;
+
+    /**
+     * @brief #getAtoms Get the atoms of all simulations in the batch.
+     * @return The atoms of all simulations.
+     */
+    const ComplexVectorBatch& getAtoms() const { return atoms; }
+
+private:
+    void notify(Observable::CheckTime time);
+
+    ComplexVectorBatch atoms;
+    std::vector<std::shared_ptr<Simulation>> members;
+};
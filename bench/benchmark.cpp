@@ -0,0 +1,391 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <complex>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <new>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#include <boost/program_options/options_description.hpp>
+#include <boost/program_options/parsers.hpp>
+#include <boost/program_options/variables_map.hpp>
+
+#include "simulation.h"
+#include "linearhamiltonian.h"
+#include "nonlinearhamiltonian.h"
+#include "timedependenthamiltonian.h"
+#include "feedbackhamiltonian.h"
+#include "properbilityoberservable.h"
+#include "expectationvalueobservable.h"
+#include "projectionobservable.h"
+#include "streamdensity.h"
+#include "trajectoryobservable.h"
+
+using namespace boost::program_options;
+
+namespace {
+
+std::atomic<unsigned long long> allocationCount(0);
+std::atomic<unsigned long long> allocationBytes(0);
+
+#if defined(__GNUC__)
+#define BENCH_NOINLINE __attribute__((noinline))
+#else
+#define BENCH_NOINLINE
+#endif
+
+// the replacement operators forward to this pair instead of calling malloc and free themselves, otherwise the
+// compiler inlines them into the callers and reports every delete as a free of memory from operator new
+BENCH_NOINLINE void* countedAllocate(std::size_t size) {
+    ++allocationCount;
+    allocationBytes += size;
+    return std::malloc(size > 0 ? size : 1);
+}
+
+BENCH_NOINLINE void countedRelease(void* memory) noexcept {
+    std::free(memory);
+}
+
+}
+
+// every allocation of the benchmark gets counted, including the ones of the solver threads
+void* operator new(std::size_t size) {
+    if (void* memory = countedAllocate(size)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* memory) noexcept {
+    countedRelease(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+    countedRelease(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    countedRelease(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept {
+    countedRelease(memory);
+}
+
+namespace {
+
+typedef std::function<std::shared_ptr<ComplexHamiltonianSolver> (const SimulationParameter&)> SolverFactory;
+typedef std::function<std::shared_ptr<Observable> (std::ostream&, const std::string&)> ObservableFactory;
+
+/**
+ * @brief The CountingBuffer class is a stream buffer which drops the output and only counts its bytes.
+ */
+class CountingBuffer : public std::streambuf
+{
+public:
+    CountingBuffer() : bytes(0) {
+    }
+
+    unsigned long long bytes;
+
+protected:
+    virtual int_type overflow(int_type c) override {
+        if (!traits_type::eq_int_type(c, traits_type::eof())) {
+            ++bytes;
+        }
+        return traits_type::not_eof(c);
+    }
+
+    virtual std::streamsize xsputn(const char* s, std::streamsize count) override {
+        bytes += count;
+        return count;
+    }
+};
+
+/**
+ * @brief The BenchmarkWave class is a gaussian wave packet in the middle of the grid.
+ */
+class BenchmarkWave : public ComplexWave
+{
+public:
+    BenchmarkWave(unsigned int AtomCount) : atomCount(AtomCount) {
+    }
+
+    virtual std::complex<double> getDisplacement(unsigned int index) const override {
+        const double x = static_cast<double>(index) / atomCount - 0.5;
+        return std::exp(-x * x / (2 * 0.05 * 0.05)) * std::polar(1.0, 200.0 * x);
+    }
+
+private:
+    unsigned int atomCount;
+};
+
+/**
+ * @brief The Result struct holds one measurement of a solver or an observable on a grid.
+ */
+struct Result {
+    std::string kind;
+    std::string name;
+    unsigned int atoms;
+    unsigned int threads;
+    unsigned int steps;
+    double time;
+    unsigned long long allocations;
+    unsigned long long allocatedBytes;
+    unsigned long long outputBytes;
+};
+
+/**
+ * @brief The Counters struct is a snapshot of the clock and the allocation counters.
+ */
+struct Counters {
+    Counters()
+        : time(std::chrono::steady_clock::now()), allocations(allocationCount.load()), bytes(allocationBytes.load()) {
+    }
+
+    std::chrono::steady_clock::time_point time;
+    unsigned long long allocations;
+    unsigned long long bytes;
+};
+
+Result finish(const std::string& kind, const std::string& name, const SimulationParameter& parameter,
+              unsigned int steps, const Counters& start, const Counters& stop, unsigned long long outputBytes) {
+    Result result;
+    result.kind = kind;
+    result.name = name;
+    result.atoms = parameter.atomCount;
+    result.threads = parameter.threads;
+    result.steps = steps;
+    result.time = std::chrono::duration<double>(stop.time - start.time).count();
+    result.allocations = stop.allocations - start.allocations;
+    result.allocatedBytes = stop.bytes - start.bytes;
+    result.outputBytes = outputBytes;
+    return result;
+}
+
+/**
+ * @brief The StepProbe class is an iteration observable which takes the counters in the simulation loop,
+ *        the first time after the warm up steps and then after every further step.
+ */
+class StepProbe : public Observable
+{
+public:
+    StepProbe(unsigned int WarmUp) : Observable(Observable::Iteration), warmUp(WarmUp), calls(0) {
+    }
+
+    virtual void filter(const Simulation&) override {
+        if (++calls == warmUp) {
+            start = Counters();
+        } else if (calls > warmUp) {
+            stop = Counters();
+        }
+    }
+
+    unsigned int warmUp;
+    unsigned int calls;
+    Counters start;
+    Counters stop;
+};
+
+/**
+ * @brief #benchmarkSolver Measure the steps of a solver in Simulation::run, the first steps are not measured,
+ *                         because they may build the matrices of the partitioned solve.
+ */
+Result benchmarkSolver(const std::string& name, const SolverFactory& factory,
+                       const SimulationParameter& parameter, unsigned int steps) {
+    const unsigned int warmUp = 2;
+    const SimulationParameter runParameter(parameter.dx, parameter.dt, parameter.mass, warmUp + steps,
+                                           parameter.atomCount, parameter.threads);
+    Simulation simulation(runParameter, factory(runParameter));
+    BenchmarkWave wave(parameter.atomCount);
+    simulation.addWave(&wave);
+    std::shared_ptr<StepProbe> probe = std::make_shared<StepProbe>(warmUp);
+    simulation.addFilter(probe);
+
+    simulation.run();
+    return finish("solver", name, parameter, steps, probe->start, probe->stop, 0);
+}
+
+/**
+ * @brief #benchmarkObservable Measure the filter calls of an observable on the state of a linear simulation.
+ */
+Result benchmarkObservable(const std::string& name, const ObservableFactory& factory,
+                           const SimulationParameter& parameter, unsigned int steps) {
+    const std::string filename = "cranknicolson_bench.traj";
+    std::shared_ptr<ComplexHamiltonianSolver> solver =
+            std::make_shared<LinearHamiltonianSolver<std::complex<double>>>(parameter, std::vector<double>(parameter.atomCount, 0.0));
+    Simulation simulation(parameter, solver);
+    BenchmarkWave wave(parameter.atomCount);
+    simulation.addWave(&wave);
+
+    CountingBuffer buffer;
+    std::ostream output(&buffer);
+    std::shared_ptr<Observable> observable = factory(output, filename);
+    observable->filter(simulation);
+    buffer.bytes = 0;
+
+    const Counters start;
+    for (unsigned int i = 0; i < steps; ++i) {
+        observable->filter(simulation);
+    }
+    Result result = finish("observable", name, parameter, steps, start, Counters(), buffer.bytes);
+
+    observable.reset();
+    std::ifstream file(filename.c_str(), std::ios::binary | std::ios::ate);
+    if (file) {
+        // the frame written before the measurement shares the header and the index of the file
+        const unsigned long long size = static_cast<unsigned long long>(file.tellg());
+        result.outputBytes = size * steps / (steps + 1);
+        file.close();
+        std::remove(filename.c_str());
+    }
+    return result;
+}
+
+void writeJson(std::ostream& output, const std::vector<Result>& results) {
+    output << "{\n  \"compiler\": \"" << __VERSION__ << "\",\n  \"results\": [";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        output << (i == 0 ? "\n" : ",\n")
+               << "    {\"kind\": \"" << r.kind << "\", \"name\": \"" << r.name << "\""
+               << ", \"atoms\": " << r.atoms
+               << ", \"threads\": " << r.threads
+               << ", \"steps\": " << r.steps
+               << ", \"time\": " << r.time
+               << ", \"stepsPerSecond\": " << (r.time > 0 ? r.steps / r.time : 0.0)
+               << ", \"bytesPerStep\": " << static_cast<double>(r.outputBytes) / r.steps
+               << ", \"allocationsPerStep\": " << static_cast<double>(r.allocations) / r.steps
+               << ", \"allocatedBytesPerStep\": " << static_cast<double>(r.allocatedBytes) / r.steps << "}";
+    }
+    output << "\n  ]\n}\n";
+}
+
+}
+
+int main(int argc, char** argv) {
+    options_description desc(
+        "Benchmark of the solvers and observables of the Crank Nicolson core.\n"
+        "Every solver and observable runs on every grid size and the steps per second,\n"
+        "the written bytes and the allocations per step get reported as JSON.\n"
+    );
+    desc.add_options()
+            ("help,h", "Show this help text")
+            ("sizes,s", value<std::vector<unsigned int>>()->multitoken(), "The grid sizes, default is 1000 10000 100000 1000000")
+            ("work,w", value<double>()->default_value(1e7), "The atom steps of a measurement, the step count is work / size")
+            ("steps", value<unsigned int>(), "A fixed step count for every measurement instead of --work")
+            ("threads,t", value<unsigned int>()->default_value(1), "The threads a solver may use for one step")
+            ("filter,f", value<std::string>(), "Only run the solvers and observables whose name contains this text")
+            ("check,c", "Exit with a nonzero status if a solver allocates memory in its steps")
+            ("output,o", value<std::string>(), "The JSON file to write the results into, default is stdout");
+
+    variables_map vm;
+    try {
+        store(command_line_parser(argc, argv).options(desc).run(), vm);
+        notify(vm);
+    } catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        std::cerr << desc << std::endl;
+        return 1;
+    }
+
+    if (vm.count("help")) {
+        desc.print(std::cout);
+        return 0;
+    }
+
+    const std::vector<unsigned int> sizes = vm.count("sizes") ? vm["sizes"].as<std::vector<unsigned int>>()
+                                                              : std::vector<unsigned int>{ 1000, 10000, 100000, 1000000 };
+    const unsigned int threads = vm["threads"].as<unsigned int>();
+    const std::string filter = vm.count("filter") ? vm["filter"].as<std::string>() : "";
+
+    typedef std::complex<double> T;
+    auto harmonic = [](unsigned int atomCount) {
+        std::vector<double> values(atomCount);
+        for (unsigned int i = 0; i < atomCount; ++i) {
+            const double x = static_cast<double>(i) / atomCount - 0.5;
+            values[i] = 50.0 * x * x;
+        }
+        return values;
+    };
+
+    const std::vector<std::pair<std::string, SolverFactory>> solvers = {
+        { "LinearHamiltonianSolver", [&](const SimulationParameter& p) {
+            return std::make_shared<LinearHamiltonianSolver<T>>(p, harmonic(p.atomCount)); } },
+        { "NonLinearHamiltonianSolver.Global", [&](const SimulationParameter& p) {
+            return std::make_shared<NonLinearHamiltonianSolver<T>>(p, harmonic(p.atomCount), 1.0, NonLinearHamiltonianSolver<T>::Global); } },
+        { "NonLinearHamiltonianSolver.Local", [&](const SimulationParameter& p) {
+            return std::make_shared<NonLinearHamiltonianSolver<T>>(p, harmonic(p.atomCount), 1.0, NonLinearHamiltonianSolver<T>::Local); } },
+        { "TimeDependentHamiltonianSolver", [&](const SimulationParameter& p) {
+            return std::make_shared<TimeDependentHamiltonianSolver<T>>(p, std::make_shared<ExpressionPotential>("50 * (x - 0.5 - 0.1 * sin(1e4 * t))^2")); } },
+        { "FeedbackHamiltonianSolver.Density", [&](const SimulationParameter& p) {
+            return std::make_shared<FeedbackHamiltonianSolver<T>>(p, harmonic(p.atomCount), std::make_shared<DensityFeedback<T>>(1.0)); } }
+    };
+
+    const std::vector<std::pair<std::string, ObservableFactory>> observables = {
+        { "ProperbilityOberservable", [](std::ostream& o, const std::string&) {
+            return std::make_shared<ProperbilityOberservable>(o); } },
+        { "RealProperbilityOberservable", [](std::ostream& o, const std::string&) {
+            return std::make_shared<RealProperbilityOberservable>(o); } },
+        { "ExpectationValueObservable", [](std::ostream& o, const std::string&) {
+            return std::make_shared<ExpectationValueObservable>(o); } },
+        { "ProperbilityFluxObservable", [](std::ostream& o, const std::string&) {
+            return std::make_shared<ProperbilityFluxObservable>(o); } },
+        { "ProjectionObservable", [](std::ostream& o, const std::string&) {
+            return std::make_shared<ProjectionObservable>(o, 32, -std::numeric_limits<double>::infinity(), std::numeric_limits<double>::infinity(), 1); } },
+        { "TrajectoryObservable", [](std::ostream&, const std::string& file) {
+            return std::make_shared<TrajectoryObservable>(file, Trajectory::Amplitude | Trajectory::Real | Trajectory::Imaginary); } }
+    };
+
+    std::vector<Result> results;
+    for (unsigned int size : sizes) {
+        const double dx = 1.0 / size;
+        const SimulationParameter parameter(dx, 2 * dx * dx, 1.0, 0, size, threads);
+        const unsigned int steps = vm.count("steps") ? vm["steps"].as<unsigned int>()
+                                                     : std::max(1u, static_cast<unsigned int>(vm["work"].as<double>() / size));
+        for (auto& it : solvers) {
+            if (it.first.find(filter) != std::string::npos) {
+                results.push_back(benchmarkSolver(it.first, it.second, parameter, steps));
+                std::cerr << it.first << " " << size << ": " << results.back().steps / results.back().time << " steps/s" << std::endl;
+            }
+        }
+        for (auto& it : observables) {
+            if (it.first.find(filter) != std::string::npos) {
+                results.push_back(benchmarkObservable(it.first, it.second, parameter, steps));
+                std::cerr << it.first << " " << size << ": " << results.back().steps / results.back().time << " steps/s" << std::endl;
+            }
+        }
+    }
+
+    if (vm.count("output")) {
+        std::ofstream output(vm["output"].as<std::string>().c_str());
+        writeJson(output, results);
+    } else {
+        writeJson(std::cout, results);
+    }
+
+    if (vm.count("check")) {
+        int status = 0;
+        for (const Result& r : results) {
+            if (r.kind == "solver" && r.allocations > 0) {
+                std::cerr << "check failed: " << r.name << " " << r.atoms << " allocates "
+                          << static_cast<double>(r.allocations) / r.steps << " times per step" << std::endl;
+                status = 1;
+            }
+        }
+        return status;
+    }
+    return 0;
+}
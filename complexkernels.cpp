@@ -0,0 +1,539 @@
+#include "complexkernels.h"
+
+#include <algorithm>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define CN_X86_KERNELS 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+typedef ComplexKernels::Complex Complex;
+
+// The portable kernels work on the real and imaginary parts directly, which avoids the
+// NaN recovery of the std::complex multiplication and lets the compiler vectorize them.
+
+inline void mul(double ar, double ai, double br, double bi, double& r, double& i) {
+    r = ar * br - ai * bi;
+    i = ar * bi + ai * br;
+}
+
+Complex dotGeneric(const Complex* a, const Complex* b, unsigned int size) {
+    const double* x = reinterpret_cast<const double*>(a);
+    const double* y = reinterpret_cast<const double*>(b);
+    double real = 0, imag = 0;
+    for (unsigned int i = 0; i < size; ++i) {
+        real += x[2 * i] * y[2 * i] + x[2 * i + 1] * y[2 * i + 1];
+        imag += x[2 * i] * y[2 * i + 1] - x[2 * i + 1] * y[2 * i];
+    }
+    return Complex(real, imag);
+}
+
+double squaredNormGeneric(const Complex* a, unsigned int size) {
+    const double* x = reinterpret_cast<const double*>(a);
+    double sum = 0;
+    for (unsigned int i = 0; i < 2 * size; ++i) {
+        sum += x[i] * x[i];
+    }
+    return sum;
+}
+
+void multiplyGeneric(const Complex* upper, const Complex* diagonal, const Complex* lower,
+                     const Complex* x, Complex* result, unsigned int size) {
+    const double* u = reinterpret_cast<const double*>(upper);
+    const double* d = reinterpret_cast<const double*>(diagonal);
+    const double* l = reinterpret_cast<const double*>(lower);
+    const double* v = reinterpret_cast<const double*>(x);
+    double* r = reinterpret_cast<double*>(result);
+    for (unsigned int i = 1; i + 1 < size; ++i) {
+        double ur, ui, dr, di, lr, li;
+        mul(u[2 * i], u[2 * i + 1], v[2 * i - 2], v[2 * i - 1], ur, ui);
+        mul(d[2 * i], d[2 * i + 1], v[2 * i], v[2 * i + 1], dr, di);
+        mul(l[2 * i], l[2 * i + 1], v[2 * i + 2], v[2 * i + 3], lr, li);
+        r[2 * i] = ur + dr + lr;
+        r[2 * i + 1] = ui + di + li;
+    }
+}
+
+void forwardRowGeneric(Complex upper, Complex diagonal, Complex lower, Complex coupling, Complex pivot,
+                       Complex* previous, Complex* row, const Complex* last, const Complex* next, unsigned int members) {
+    double* p = reinterpret_cast<double*>(previous);
+    double* r = reinterpret_cast<double*>(row);
+    const double* s = reinterpret_cast<const double*>(last);
+    const double* n = reinterpret_cast<const double*>(next);
+    for (unsigned int j = 0; j < members; ++j) {
+        double ur, ui, dr, di, lr, li, ar, ai, sr, si;
+        const double cr = r[2 * j], ci = r[2 * j + 1];
+        mul(upper.real(), upper.imag(), p[2 * j], p[2 * j + 1], ur, ui);
+        mul(diagonal.real(), diagonal.imag(), cr, ci, dr, di);
+        mul(lower.real(), lower.imag(), n[2 * j], n[2 * j + 1], lr, li);
+        mul(coupling.real(), coupling.imag(), s[2 * j], s[2 * j + 1], ar, ai);
+        mul(ur + dr + lr - ar, ui + di + li - ai, pivot.real(), pivot.imag(), sr, si);
+        r[2 * j] = sr;
+        r[2 * j + 1] = si;
+        p[2 * j] = cr;
+        p[2 * j + 1] = ci;
+    }
+}
+
+void backwardRowGeneric(Complex multiplier, Complex* row, const Complex* next, unsigned int members) {
+    double* r = reinterpret_cast<double*>(row);
+    const double* n = reinterpret_cast<const double*>(next);
+    for (unsigned int j = 0; j < members; ++j) {
+        double mr, mi;
+        mul(multiplier.real(), multiplier.imag(), n[2 * j], n[2 * j + 1], mr, mi);
+        r[2 * j] -= mr;
+        r[2 * j + 1] -= mi;
+    }
+}
+
+void scaleGeneric(Complex* a, double factor, unsigned int size) {
+    double* x = reinterpret_cast<double*>(a);
+    for (unsigned int i = 0; i < 2 * size; ++i) {
+        x[i] *= factor;
+    }
+}
+
+// The stencil sweeps evaluate the right hand side of a block of rows before the recurrence overwrites them.
+// The block of right hand sides stays in the first level cache.
+
+const unsigned int StencilBlock = 256;
+
+/**
+ * A block of right hand sides w_k = ((1 - e h_k) x_k - c (x_{k-1} + x_{k+1})) q_k of the explicit rate e and the
+ * explicit coupling c, where q_k is the inverse pivot or one if pivot is nullptr. The neighbours outside of the
+ * block are before and after, all values of x are the old ones.
+ */
+typedef void (*RightHandSideBlock)(const double* diagonal, Complex rate, Complex coupling, const Complex* x,
+                                   Complex before, Complex after, const Complex* pivot, Complex* w, unsigned int count);
+
+inline void rightHandSideRow(double h, Complex rate, Complex coupling, Complex x, Complex neighbours, const Complex* pivot, Complex& w) {
+    double dr, di, cr, ci;
+    mul(1.0 - rate.real() * h, -rate.imag() * h, x.real(), x.imag(), dr, di);
+    mul(coupling.real(), coupling.imag(), neighbours.real(), neighbours.imag(), cr, ci);
+    if (pivot) {
+        double pr, pi;
+        mul(dr - cr, di - ci, pivot->real(), pivot->imag(), pr, pi);
+        w = Complex(pr, pi);
+    } else {
+        w = Complex(dr - cr, di - ci);
+    }
+}
+
+// the rows [begin, end) of a block of count rows, which may be the first or the last ones
+inline void rightHandSideRows(const double* diagonal, Complex rate, Complex coupling, const Complex* x, Complex before, Complex after,
+                              const Complex* pivot, Complex* w, unsigned int begin, unsigned int end, unsigned int count) {
+    for (unsigned int k = begin; k < end; ++k) {
+        const Complex neighbours = (k > 0 ? x[k - 1] : before) + (k + 1 < count ? x[k + 1] : after);
+        rightHandSideRow(diagonal[k], rate, coupling, x[k], neighbours, pivot ? pivot + k : nullptr, w[k]);
+    }
+}
+
+void rightHandSideGeneric(const double* diagonal, Complex rate, Complex coupling, const Complex* x,
+                          Complex before, Complex after, const Complex* pivot, Complex* w, unsigned int count) {
+    rightHandSideRows(diagonal, rate, coupling, x, before, after, pivot, w, 0, count, count);
+}
+
+void backSubstitution(const Complex* multiplier, Complex* x, unsigned int size) {
+    const double* m = reinterpret_cast<const double*>(multiplier);
+    double* v = reinterpret_cast<double*>(x);
+    double nr = v[2 * size - 2], ni = v[2 * size - 1];
+    for (unsigned int i = size - 1; i-- > 0;) {
+        const double cr = v[2 * i] - (m[2 * i] * nr - m[2 * i + 1] * ni);
+        const double ci = v[2 * i + 1] - (m[2 * i] * ni + m[2 * i + 1] * nr);
+        v[2 * i] = nr = cr;
+        v[2 * i + 1] = ni = ci;
+    }
+}
+
+void stencilFactorizeGeneric(const double* diagonal, Complex rate, double hopping, Complex* pivot, Complex* multiplier,
+                             unsigned int size) {
+    const Complex coupling = rate * hopping;
+    const Complex coupling2 = coupling * coupling;
+    double* p = reinterpret_cast<double*>(pivot);
+    double* m = reinterpret_cast<double*>(multiplier);
+    double lr = 0, li = 0;
+    for (unsigned int i = 0; i < size; ++i) {
+        double sr, si;
+        mul(coupling2.real(), coupling2.imag(), lr, li, sr, si);
+        const double ar = 1.0 + rate.real() * diagonal[i] - sr;
+        const double ai = rate.imag() * diagonal[i] - si;
+        const double inverse = 1.0 / (ar * ar + ai * ai);
+        lr = ar * inverse;
+        li = -ai * inverse;
+        p[2 * i] = lr;
+        p[2 * i + 1] = li;
+        mul(coupling.real(), coupling.imag(), lr, li, m[2 * i], m[2 * i + 1]);
+    }
+}
+
+template <RightHandSideBlock block>
+void stencilPropagateBlocked(const double* diagonal, Complex explicitRate, double hopping, const Complex* pivot,
+                             const Complex* multiplier, Complex* x, unsigned int size) {
+    const Complex coupling = explicitRate * hopping;
+    Complex w[StencilBlock];
+    Complex before = 0;
+    double xr = 0, xi = 0;
+    for (unsigned int begin = 0; begin < size; begin += StencilBlock) {
+        const unsigned int count = std::min(StencilBlock, size - begin);
+        const Complex after = begin + count < size ? x[begin + count] : Complex(0);
+        block(diagonal + begin, explicitRate, coupling, x + begin, before, after, pivot + begin, w, count);
+        before = x[begin + count - 1];
+
+        // x_i = w_i - m_i x_{i-1}
+        const double* m = reinterpret_cast<const double*>(multiplier + begin);
+        const double* r = reinterpret_cast<const double*>(w);
+        double* v = reinterpret_cast<double*>(x + begin);
+        for (unsigned int k = 0; k < count; ++k) {
+            const double nr = r[2 * k] - (m[2 * k] * xr - m[2 * k + 1] * xi);
+            const double ni = r[2 * k + 1] - (m[2 * k] * xi + m[2 * k + 1] * xr);
+            v[2 * k] = xr = nr;
+            v[2 * k + 1] = xi = ni;
+        }
+    }
+    backSubstitution(multiplier, x, size);
+}
+
+template <RightHandSideBlock block>
+void stencilFactorizeAndPropagateBlocked(const double* diagonal, Complex rate, Complex explicitRate, double hopping,
+                                         Complex* pivot, Complex* multiplier, Complex* x, unsigned int size) {
+    const Complex coupling = rate * hopping;
+    const Complex coupling2 = coupling * coupling;
+    const Complex explicitCoupling = explicitRate * hopping;
+    Complex w[StencilBlock];
+    Complex before = 0;
+    double xr = 0, xi = 0, lr = 0, li = 0;
+    for (unsigned int begin = 0; begin < size; begin += StencilBlock) {
+        const unsigned int count = std::min(StencilBlock, size - begin);
+        const Complex after = begin + count < size ? x[begin + count] : Complex(0);
+        block(diagonal + begin, explicitRate, explicitCoupling, x + begin, before, after, nullptr, w, count);
+        before = x[begin + count - 1];
+
+        // p_i = 1 / (1 + r h_i - c^2 p_{i-1}) and x_i = w_i p_i - m_i x_{i-1}
+        const double* h = diagonal + begin;
+        const double* r = reinterpret_cast<const double*>(w);
+        double* p = reinterpret_cast<double*>(pivot + begin);
+        double* m = reinterpret_cast<double*>(multiplier + begin);
+        double* v = reinterpret_cast<double*>(x + begin);
+        for (unsigned int k = 0; k < count; ++k) {
+            double sr, si, wr, wi, mr, mi;
+            mul(coupling2.real(), coupling2.imag(), lr, li, sr, si);
+            const double ar = 1.0 + rate.real() * h[k] - sr;
+            const double ai = rate.imag() * h[k] - si;
+            const double inverse = 1.0 / (ar * ar + ai * ai);
+            lr = ar * inverse;
+            li = -ai * inverse;
+            mul(coupling.real(), coupling.imag(), lr, li, mr, mi);
+            mul(r[2 * k], r[2 * k + 1], lr, li, wr, wi);
+            const double nr = wr - (mr * xr - mi * xi);
+            const double ni = wi - (mr * xi + mi * xr);
+            p[2 * k] = lr;
+            p[2 * k + 1] = li;
+            m[2 * k] = mr;
+            m[2 * k + 1] = mi;
+            v[2 * k] = xr = nr;
+            v[2 * k + 1] = xi = ni;
+        }
+    }
+    backSubstitution(multiplier, x, size);
+}
+
+#ifdef CN_X86_KERNELS
+
+// AVX2 kernels, every register holds two interleaved complex numbers
+
+#define CN_AVX2 __attribute__((target("avx2,fma")))
+
+// multiply the interleaved complex numbers of c and x
+CN_AVX2 inline __m256d mulAvx2(__m256d c, __m256d x) {
+    const __m256d real = _mm256_movedup_pd(c);
+    const __m256d imag = _mm256_permute_pd(c, 0xF);
+    return _mm256_fmaddsub_pd(real, x, _mm256_mul_pd(imag, _mm256_permute_pd(x, 0x5)));
+}
+
+// multiply a broadcasted complex number with the interleaved complex numbers of x
+CN_AVX2 inline __m256d mulAvx2(__m256d real, __m256d imag, __m256d x) {
+    return _mm256_fmaddsub_pd(real, x, _mm256_mul_pd(imag, _mm256_permute_pd(x, 0x5)));
+}
+
+CN_AVX2 Complex dotAvx2(const Complex* a, const Complex* b, unsigned int size) {
+    const double* x = reinterpret_cast<const double*>(a);
+    const double* y = reinterpret_cast<const double*>(b);
+    __m256d real = _mm256_setzero_pd();
+    __m256d imag = _mm256_setzero_pd();
+    unsigned int i = 0;
+    for (; i + 2 <= size; i += 2) {
+        const __m256d va = _mm256_loadu_pd(x + 2 * i);
+        const __m256d vb = _mm256_loadu_pd(y + 2 * i);
+        real = _mm256_fmadd_pd(va, vb, real);
+        imag = _mm256_fmadd_pd(va, _mm256_permute_pd(vb, 0x5), imag);
+    }
+    double r[4], m[4];
+    _mm256_storeu_pd(r, real);
+    _mm256_storeu_pd(m, imag);
+    return Complex(r[0] + r[1] + r[2] + r[3], m[0] - m[1] + m[2] - m[3]) + dotGeneric(a + i, b + i, size - i);
+}
+
+CN_AVX2 double squaredNormAvx2(const Complex* a, unsigned int size) {
+    const double* x = reinterpret_cast<const double*>(a);
+    __m256d sum = _mm256_setzero_pd();
+    unsigned int i = 0;
+    for (; i + 2 <= size; i += 2) {
+        const __m256d v = _mm256_loadu_pd(x + 2 * i);
+        sum = _mm256_fmadd_pd(v, v, sum);
+    }
+    double s[4];
+    _mm256_storeu_pd(s, sum);
+    return s[0] + s[1] + s[2] + s[3] + squaredNormGeneric(a + i, size - i);
+}
+
+CN_AVX2 void multiplyAvx2(const Complex* upper, const Complex* diagonal, const Complex* lower,
+                          const Complex* x, Complex* result, unsigned int size) {
+    const double* u = reinterpret_cast<const double*>(upper);
+    const double* d = reinterpret_cast<const double*>(diagonal);
+    const double* l = reinterpret_cast<const double*>(lower);
+    const double* v = reinterpret_cast<const double*>(x);
+    double* r = reinterpret_cast<double*>(result);
+    unsigned int i = 1;
+    for (; i + 3 <= size; i += 2) {
+        __m256d sum = mulAvx2(_mm256_loadu_pd(u + 2 * i), _mm256_loadu_pd(v + 2 * i - 2));
+        sum = _mm256_add_pd(sum, mulAvx2(_mm256_loadu_pd(d + 2 * i), _mm256_loadu_pd(v + 2 * i)));
+        sum = _mm256_add_pd(sum, mulAvx2(_mm256_loadu_pd(l + 2 * i), _mm256_loadu_pd(v + 2 * i + 2)));
+        _mm256_storeu_pd(r + 2 * i, sum);
+    }
+    if (i + 1 < size) {
+        multiplyGeneric(upper + i - 1, diagonal + i - 1, lower + i - 1, x + i - 1, result + i - 1, size - i + 1);
+    }
+}
+
+CN_AVX2 void forwardRowAvx2(Complex upper, Complex diagonal, Complex lower, Complex coupling, Complex pivot,
+                            Complex* previous, Complex* row, const Complex* last, const Complex* next, unsigned int members) {
+    double* p = reinterpret_cast<double*>(previous);
+    double* r = reinterpret_cast<double*>(row);
+    const double* s = reinterpret_cast<const double*>(last);
+    const double* n = reinterpret_cast<const double*>(next);
+    const __m256d ur = _mm256_set1_pd(upper.real()), ui = _mm256_set1_pd(upper.imag());
+    const __m256d dr = _mm256_set1_pd(diagonal.real()), di = _mm256_set1_pd(diagonal.imag());
+    const __m256d lr = _mm256_set1_pd(lower.real()), li = _mm256_set1_pd(lower.imag());
+    const __m256d ar = _mm256_set1_pd(coupling.real()), ai = _mm256_set1_pd(coupling.imag());
+    const __m256d pr = _mm256_set1_pd(pivot.real()), pi = _mm256_set1_pd(pivot.imag());
+    unsigned int j = 0;
+    for (; j + 2 <= members; j += 2) {
+        const __m256d current = _mm256_loadu_pd(r + 2 * j);
+        __m256d sum = mulAvx2(ur, ui, _mm256_loadu_pd(p + 2 * j));
+        sum = _mm256_add_pd(sum, mulAvx2(dr, di, current));
+        sum = _mm256_add_pd(sum, mulAvx2(lr, li, _mm256_loadu_pd(n + 2 * j)));
+        sum = _mm256_sub_pd(sum, mulAvx2(ar, ai, _mm256_loadu_pd(s + 2 * j)));
+        _mm256_storeu_pd(r + 2 * j, mulAvx2(pr, pi, sum));
+        _mm256_storeu_pd(p + 2 * j, current);
+    }
+    forwardRowGeneric(upper, diagonal, lower, coupling, pivot, previous + j, row + j, last + j, next + j, members - j);
+}
+
+CN_AVX2 void backwardRowAvx2(Complex multiplier, Complex* row, const Complex* next, unsigned int members) {
+    double* r = reinterpret_cast<double*>(row);
+    const double* n = reinterpret_cast<const double*>(next);
+    const __m256d mr = _mm256_set1_pd(multiplier.real()), mi = _mm256_set1_pd(multiplier.imag());
+    unsigned int j = 0;
+    for (; j + 2 <= members; j += 2) {
+        _mm256_storeu_pd(r + 2 * j, _mm256_sub_pd(_mm256_loadu_pd(r + 2 * j), mulAvx2(mr, mi, _mm256_loadu_pd(n + 2 * j))));
+    }
+    backwardRowGeneric(multiplier, row + j, next + j, members - j);
+}
+
+CN_AVX2 void scaleAvx2(Complex* a, double factor, unsigned int size) {
+    double* x = reinterpret_cast<double*>(a);
+    const __m256d f = _mm256_set1_pd(factor);
+    unsigned int i = 0;
+    for (; i + 2 <= size; i += 2) {
+        _mm256_storeu_pd(x + 2 * i, _mm256_mul_pd(_mm256_loadu_pd(x + 2 * i), f));
+    }
+    scaleGeneric(a + i, factor, size - i);
+}
+
+CN_AVX2 void rightHandSideAvx2(const double* diagonal, Complex rate, Complex coupling, const Complex* x,
+                               Complex before, Complex after, const Complex* pivot, Complex* w, unsigned int count) {
+    const double* v = reinterpret_cast<const double*>(x);
+    const double* p = reinterpret_cast<const double*>(pivot);
+    double* r = reinterpret_cast<double*>(w);
+    const __m256d one = _mm256_set_pd(0, 1, 0, 1);
+    const __m256d rates = _mm256_set_pd(rate.imag(), rate.real(), rate.imag(), rate.real());
+    const __m256d cr = _mm256_set1_pd(coupling.real()), ci = _mm256_set1_pd(coupling.imag());
+    rightHandSideRows(diagonal, rate, coupling, x, before, after, pivot, w, 0, std::min(count, 1u), count);
+    unsigned int k = 1;
+    for (; k + 3 <= count; k += 2) {
+        // (h_k, h_k, h_k+1, h_k+1) scales the interleaved rate
+        const __m256d h = _mm256_permute4x64_pd(_mm256_castpd128_pd256(_mm_loadu_pd(diagonal + k)), 0x50);
+        const __m256d neighbours = _mm256_add_pd(_mm256_loadu_pd(v + 2 * k - 2), _mm256_loadu_pd(v + 2 * k + 2));
+        __m256d sum = mulAvx2(_mm256_fnmadd_pd(rates, h, one), _mm256_loadu_pd(v + 2 * k));
+        sum = _mm256_sub_pd(sum, mulAvx2(cr, ci, neighbours));
+        if (p) {
+            sum = mulAvx2(_mm256_loadu_pd(p + 2 * k), sum);
+        }
+        _mm256_storeu_pd(r + 2 * k, sum);
+    }
+    rightHandSideRows(diagonal, rate, coupling, x, before, after, pivot, w, k, count, count);
+}
+
+// AVX-512 kernels, every register holds four interleaved complex numbers
+
+#define CN_AVX512 __attribute__((target("avx512f")))
+
+CN_AVX512 inline __m512d mulAvx512(__m512d c, __m512d x) {
+    const __m512d real = _mm512_movedup_pd(c);
+    const __m512d imag = _mm512_permute_pd(c, 0xFF);
+    return _mm512_fmaddsub_pd(real, x, _mm512_mul_pd(imag, _mm512_permute_pd(x, 0x55)));
+}
+
+CN_AVX512 inline __m512d mulAvx512(__m512d real, __m512d imag, __m512d x) {
+    return _mm512_fmaddsub_pd(real, x, _mm512_mul_pd(imag, _mm512_permute_pd(x, 0x55)));
+}
+
+CN_AVX512 Complex dotAvx512(const Complex* a, const Complex* b, unsigned int size) {
+    const double* x = reinterpret_cast<const double*>(a);
+    const double* y = reinterpret_cast<const double*>(b);
+    __m512d real = _mm512_setzero_pd();
+    __m512d imag = _mm512_setzero_pd();
+    unsigned int i = 0;
+    for (; i + 4 <= size; i += 4) {
+        const __m512d va = _mm512_loadu_pd(x + 2 * i);
+        const __m512d vb = _mm512_loadu_pd(y + 2 * i);
+        real = _mm512_fmadd_pd(va, vb, real);
+        imag = _mm512_fmadd_pd(va, _mm512_permute_pd(vb, 0x55), imag);
+    }
+    const __m512d sign = _mm512_set_pd(-1, 1, -1, 1, -1, 1, -1, 1);
+    return Complex(_mm512_reduce_add_pd(real), _mm512_reduce_add_pd(_mm512_mul_pd(imag, sign))) +
+           dotGeneric(a + i, b + i, size - i);
+}
+
+CN_AVX512 double squaredNormAvx512(const Complex* a, unsigned int size) {
+    const double* x = reinterpret_cast<const double*>(a);
+    __m512d sum = _mm512_setzero_pd();
+    unsigned int i = 0;
+    for (; i + 4 <= size; i += 4) {
+        const __m512d v = _mm512_loadu_pd(x + 2 * i);
+        sum = _mm512_fmadd_pd(v, v, sum);
+    }
+    return _mm512_reduce_add_pd(sum) + squaredNormGeneric(a + i, size - i);
+}
+
+CN_AVX512 void multiplyAvx512(const Complex* upper, const Complex* diagonal, const Complex* lower,
+                              const Complex* x, Complex* result, unsigned int size) {
+    const double* u = reinterpret_cast<const double*>(upper);
+    const double* d = reinterpret_cast<const double*>(diagonal);
+    const double* l = reinterpret_cast<const double*>(lower);
+    const double* v = reinterpret_cast<const double*>(x);
+    double* r = reinterpret_cast<double*>(result);
+    unsigned int i = 1;
+    for (; i + 5 <= size; i += 4) {
+        __m512d sum = mulAvx512(_mm512_loadu_pd(u + 2 * i), _mm512_loadu_pd(v + 2 * i - 2));
+        sum = _mm512_add_pd(sum, mulAvx512(_mm512_loadu_pd(d + 2 * i), _mm512_loadu_pd(v + 2 * i)));
+        sum = _mm512_add_pd(sum, mulAvx512(_mm512_loadu_pd(l + 2 * i), _mm512_loadu_pd(v + 2 * i + 2)));
+        _mm512_storeu_pd(r + 2 * i, sum);
+    }
+    if (i + 1 < size) {
+        multiplyGeneric(upper + i - 1, diagonal + i - 1, lower + i - 1, x + i - 1, result + i - 1, size - i + 1);
+    }
+}
+
+CN_AVX512 void forwardRowAvx512(Complex upper, Complex diagonal, Complex lower, Complex coupling, Complex pivot,
+                                Complex* previous, Complex* row, const Complex* last, const Complex* next, unsigned int members) {
+    double* p = reinterpret_cast<double*>(previous);
+    double* r = reinterpret_cast<double*>(row);
+    const double* s = reinterpret_cast<const double*>(last);
+    const double* n = reinterpret_cast<const double*>(next);
+    const __m512d ur = _mm512_set1_pd(upper.real()), ui = _mm512_set1_pd(upper.imag());
+    const __m512d dr = _mm512_set1_pd(diagonal.real()), di = _mm512_set1_pd(diagonal.imag());
+    const __m512d lr = _mm512_set1_pd(lower.real()), li = _mm512_set1_pd(lower.imag());
+    const __m512d ar = _mm512_set1_pd(coupling.real()), ai = _mm512_set1_pd(coupling.imag());
+    const __m512d pr = _mm512_set1_pd(pivot.real()), pi = _mm512_set1_pd(pivot.imag());
+    unsigned int j = 0;
+    for (; j + 4 <= members; j += 4) {
+        const __m512d current = _mm512_loadu_pd(r + 2 * j);
+        __m512d sum = mulAvx512(ur, ui, _mm512_loadu_pd(p + 2 * j));
+        sum = _mm512_add_pd(sum, mulAvx512(dr, di, current));
+        sum = _mm512_add_pd(sum, mulAvx512(lr, li, _mm512_loadu_pd(n + 2 * j)));
+        sum = _mm512_sub_pd(sum, mulAvx512(ar, ai, _mm512_loadu_pd(s + 2 * j)));
+        _mm512_storeu_pd(r + 2 * j, mulAvx512(pr, pi, sum));
+        _mm512_storeu_pd(p + 2 * j, current);
+    }
+    forwardRowGeneric(upper, diagonal, lower, coupling, pivot, previous + j, row + j, last + j, next + j, members - j);
+}
+
+CN_AVX512 void backwardRowAvx512(Complex multiplier, Complex* row, const Complex* next, unsigned int members) {
+    double* r = reinterpret_cast<double*>(row);
+    const double* n = reinterpret_cast<const double*>(next);
+    const __m512d mr = _mm512_set1_pd(multiplier.real()), mi = _mm512_set1_pd(multiplier.imag());
+    unsigned int j = 0;
+    for (; j + 4 <= members; j += 4) {
+        _mm512_storeu_pd(r + 2 * j, _mm512_sub_pd(_mm512_loadu_pd(r + 2 * j), mulAvx512(mr, mi, _mm512_loadu_pd(n + 2 * j))));
+    }
+    backwardRowGeneric(multiplier, row + j, next + j, members - j);
+}
+
+CN_AVX512 void scaleAvx512(Complex* a, double factor, unsigned int size) {
+    double* x = reinterpret_cast<double*>(a);
+    const __m512d f = _mm512_set1_pd(factor);
+    unsigned int i = 0;
+    for (; i + 4 <= size; i += 4) {
+        _mm512_storeu_pd(x + 2 * i, _mm512_mul_pd(_mm512_loadu_pd(x + 2 * i), f));
+    }
+    scaleGeneric(a + i, factor, size - i);
+}
+
+CN_AVX512 void rightHandSideAvx512(const double* diagonal, Complex rate, Complex coupling, const Complex* x,
+                                   Complex before, Complex after, const Complex* pivot, Complex* w, unsigned int count) {
+    const double* v = reinterpret_cast<const double*>(x);
+    const double* p = reinterpret_cast<const double*>(pivot);
+    double* r = reinterpret_cast<double*>(w);
+    const __m512d one = _mm512_set_pd(0, 1, 0, 1, 0, 1, 0, 1);
+    const __m512d rates = _mm512_set_pd(rate.imag(), rate.real(), rate.imag(), rate.real(),
+                                        rate.imag(), rate.real(), rate.imag(), rate.real());
+    const __m512d cr = _mm512_set1_pd(coupling.real()), ci = _mm512_set1_pd(coupling.imag());
+    const __m512i duplicate = _mm512_set_epi64(3, 3, 2, 2, 1, 1, 0, 0);
+    rightHandSideRows(diagonal, rate, coupling, x, before, after, pivot, w, 0, std::min(count, 1u), count);
+    unsigned int k = 1;
+    for (; k + 5 <= count; k += 4) {
+        const __m512d h = _mm512_permutexvar_pd(duplicate, _mm512_castpd256_pd512(_mm256_loadu_pd(diagonal + k)));
+        const __m512d neighbours = _mm512_add_pd(_mm512_loadu_pd(v + 2 * k - 2), _mm512_loadu_pd(v + 2 * k + 2));
+        __m512d sum = mulAvx512(_mm512_fnmadd_pd(rates, h, one), _mm512_loadu_pd(v + 2 * k));
+        sum = _mm512_sub_pd(sum, mulAvx512(cr, ci, neighbours));
+        if (p) {
+            sum = mulAvx512(_mm512_loadu_pd(p + 2 * k), sum);
+        }
+        _mm512_storeu_pd(r + 2 * k, sum);
+    }
+    rightHandSideRows(diagonal, rate, coupling, x, before, after, pivot, w, k, count, count);
+}
+
+#endif // CN_X86_KERNELS
+
+ComplexKernels select() {
+#ifdef CN_X86_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        ComplexKernels kernels = { dotAvx512, squaredNormAvx512, scaleAvx512, multiplyAvx512, forwardRowAvx512, backwardRowAvx512,
+                                   stencilFactorizeGeneric, stencilPropagateBlocked<rightHandSideAvx512>,
+                                   stencilFactorizeAndPropagateBlocked<rightHandSideAvx512>, "avx512" };
+        return kernels;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        ComplexKernels kernels = { dotAvx2, squaredNormAvx2, scaleAvx2, multiplyAvx2, forwardRowAvx2, backwardRowAvx2,
+                                   stencilFactorizeGeneric, stencilPropagateBlocked<rightHandSideAvx2>,
+                                   stencilFactorizeAndPropagateBlocked<rightHandSideAvx2>, "avx2" };
+        return kernels;
+    }
+#endif
+    ComplexKernels kernels = { dotGeneric, squaredNormGeneric, scaleGeneric, multiplyGeneric, forwardRowGeneric, backwardRowGeneric,
+                               stencilFactorizeGeneric, stencilPropagateBlocked<rightHandSideGeneric>,
+                               stencilFactorizeAndPropagateBlocked<rightHandSideGeneric>, "generic" };
+    return kernels;
+}
+
+} // namespace
+
+const ComplexKernels& ComplexKernels::get() {
+    static const ComplexKernels kernels = select();
+    return kernels;
+}
@@ -0,0 +1,200 @@
+#pragma once
+
+#include <complex>
+
+/**
+ * @brief The ComplexKernels struct holds the vectorized loops over arrays of std::complex<double>.
+ *        The arrays keep the interleaved layout of std::complex<double>, the kernels split the real
+ *        and imaginary parts in the registers and use plain floating point arithmetic instead of the
+ *        std::complex operators. The best implementation for the current processor (AVX-512, AVX2
+ *        or a portable fallback) gets selected once at runtime.
+ *        The tridiagonal kernels use the naming of TridiagonalMatrix, where the Upper line couples
+ *        to the previous and the Lower line to the next element.
+ *        The stencil kernels are the Crank Nicolson sweeps of StencilPropagator. The substitution is a recurrence
+ *        over the rows, so they evaluate the right hand side of a block of rows with vector instructions and only
+ *        run the recurrence row by row, with the precomputed multipliers \f$ m_i = c\,p_i \f$ and split real and
+ *        imaginary parts, which keeps a single complex multiplication on the dependency chain.
+ */
+struct ComplexKernels {
+    typedef std::complex<double> Complex;
+
+    /**
+     * @brief dot Compute the dot product \f$ \sum_i \overline{a_i} b_i \f$.
+     */
+    Complex (*dot)(const Complex* a, const Complex* b, unsigned int size);
+
+    /**
+     * @brief squaredNorm Compute the squared euclidian norm \f$ \sum_i |a_i|^2 \f$.
+     */
+    double (*squaredNorm)(const Complex* a, unsigned int size);
+
+    /**
+     * @brief scale Multiply all elements with a real factor, \f$ a_i = f a_i \f$.
+     */
+    void (*scale)(Complex* a, double factor, unsigned int size);
+
+    /**
+     * @brief multiply Compute the product of a tridiagonal matrix with a vector for the rows [1, size - 1),
+     *        \f$ r_i = u_i x_{i-1} + d_i x_i + l_i x_{i+1} \f$. The first and the last row are left to the caller.
+     */
+    void (*multiply)(const Complex* upper, const Complex* diagonal, const Complex* lower,
+                     const Complex* x, Complex* result, unsigned int size);
+
+    /**
+     * @brief forwardRow One row of the batched fused forward substitution for all members:
+     *        \f$ r_j = (u p_j + d r_j + l n_j - a s_j) \cdot q \f$ while \f$ p_j \f$ receives the old \f$ r_j \f$.
+     */
+    void (*forwardRow)(Complex upper, Complex diagonal, Complex lower, Complex coupling, Complex pivot,
+                       Complex* previous, Complex* row, const Complex* last, const Complex* next, unsigned int members);
+
+    /**
+     * @brief backwardRow One row of the batched back substitution for all members: \f$ r_j = r_j - c n_j \f$.
+     */
+    void (*backwardRow)(Complex multiplier, Complex* row, const Complex* next, unsigned int members);
+
+    /**
+     * @brief stencilFactorize Compute the inverse pivots \f$ p_i \f$ of \f$ 1 + r H \f$ for a stencil with the real
+     *        diagonal \f$ h_i \f$ and the hopping \f$ t \f$ and the multipliers \f$ m_i = r t p_i \f$.
+     */
+    void (*stencilFactorize)(const double* diagonal, Complex rate, double hopping, Complex* pivot, Complex* multiplier,
+                             unsigned int size);
+
+    /**
+     * @brief stencilPropagate Compute \f$ x = (1 + r H)^{-1} (1 - e H) x \f$ inplace with the factorization of
+     *        #stencilFactorize, where \f$ e \f$ is the explicit rate of the right matrix.
+     */
+    void (*stencilPropagate)(const double* diagonal, Complex explicitRate, double hopping, const Complex* pivot,
+                             const Complex* multiplier, Complex* x, unsigned int size);
+
+    /**
+     * @brief stencilFactorizeAndPropagate #stencilFactorize within the forward substitution of #stencilPropagate.
+     */
+    void (*stencilFactorizeAndPropagate)(const double* diagonal, Complex rate, Complex explicitRate, double hopping,
+                                         Complex* pivot, Complex* multiplier, Complex* x, unsigned int size);
+
+    /**
+     * @brief name The name of the selected instruction set.
+     */
+    const char* name;
+
+    /**
+     * @brief #get Return the kernels for the current processor.
+     * @return The selected kernels.
+     */
+    static const ComplexKernels& get();
+};
+
+/**
+ * @brief #batchForwardRow One row of the batched fused forward substitution, see ComplexKernels::forwardRow.
+ *        The overload for std::complex<double> uses the selected kernel, every other type a plain loop.
+ */
+template <typename T>
+inline void batchForwardRow(T upper, T diagonal, T lower, T coupling, T pivot,
+                            T* previous, T* row, const T* last, const T* next, unsigned int members) {
+    for (unsigned int j = 0; j < members; ++j) {
+        const T current = row[j];
+        row[j] = (upper * previous[j] + diagonal * current + lower * next[j] - coupling * last[j]) * pivot;
+        previous[j] = current;
+    }
+}
+
+inline void batchForwardRow(std::complex<double> upper, std::complex<double> diagonal, std::complex<double> lower,
+                            std::complex<double> coupling, std::complex<double> pivot, std::complex<double>* previous,
+                            std::complex<double>* row, const std::complex<double>* last, const std::complex<double>* next,
+                            unsigned int members) {
+    ComplexKernels::get().forwardRow(upper, diagonal, lower, coupling, pivot, previous, row, last, next, members);
+}
+
+/**
+ * @brief #batchBackwardRow One row of the batched back substitution, see ComplexKernels::backwardRow.
+ *        The overload for std::complex<double> uses the selected kernel, every other type a plain loop.
+ */
+template <typename T>
+inline void batchBackwardRow(T multiplier, T* row, const T* next, unsigned int members) {
+    for (unsigned int j = 0; j < members; ++j) {
+        row[j] -= multiplier * next[j];
+    }
+}
+
+inline void batchBackwardRow(std::complex<double> multiplier, std::complex<double>* row, const std::complex<double>* next, unsigned int members) {
+    ComplexKernels::get().backwardRow(multiplier, row, next, members);
+}
+
+/**
+ * @brief #stencilFactorize Factorize the left matrix of a stencil, see ComplexKernels::stencilFactorize.
+ *        The overload for std::complex<double> uses the selected kernel, every other type a plain loop.
+ */
+template <typename T>
+inline void stencilFactorize(const double* diagonal, T rate, double hopping, T* pivot, T* multiplier, unsigned int size) {
+    const T coupling = rate * hopping;
+    T last = T(0);
+    for (unsigned int i = 0; i < size; ++i) {
+        pivot[i] = T(1) / (T(1) + rate * diagonal[i] - coupling * coupling * last);
+        multiplier[i] = coupling * pivot[i];
+        last = pivot[i];
+    }
+}
+
+inline void stencilFactorize(const double* diagonal, std::complex<double> rate, double hopping, std::complex<double>* pivot,
+                             std::complex<double>* multiplier, unsigned int size) {
+    ComplexKernels::get().stencilFactorize(diagonal, rate, hopping, pivot, multiplier, size);
+}
+
+/**
+ * @brief #stencilPropagate The factorized sweep of a stencil, see ComplexKernels::stencilPropagate.
+ *        The overload for std::complex<double> uses the selected kernel, every other type a plain loop.
+ */
+template <typename T>
+inline void stencilPropagate(const double* diagonal, T explicitRate, double hopping, const T* pivot, const T* multiplier,
+                             T* x, unsigned int size) {
+    const T coupling = explicitRate * hopping;
+    T previous = T(0);
+    for (unsigned int i = 0; i < size; ++i) {
+        const T current = x[i];
+        const T neighbours = i + 1 < size ? previous + x[i + 1] : previous;
+        const T rhs = (T(1) - explicitRate * diagonal[i]) * current - coupling * neighbours;
+        x[i] = i > 0 ? rhs * pivot[i] - multiplier[i] * x[i - 1] : rhs * pivot[i];
+        previous = current;
+    }
+    for (unsigned int i = size - 1; i-- > 0;) {
+        x[i] -= multiplier[i] * x[i + 1];
+    }
+}
+
+inline void stencilPropagate(const double* diagonal, std::complex<double> explicitRate, double hopping, const std::complex<double>* pivot,
+                             const std::complex<double>* multiplier, std::complex<double>* x, unsigned int size) {
+    ComplexKernels::get().stencilPropagate(diagonal, explicitRate, hopping, pivot, multiplier, x, size);
+}
+
+/**
+ * @brief #stencilFactorizeAndPropagate The sweep of a stencil which factorizes on the way, see
+ *        ComplexKernels::stencilFactorizeAndPropagate. The overload for std::complex<double> uses the selected kernel,
+ *        every other type a plain loop.
+ */
+template <typename T>
+inline void stencilFactorizeAndPropagate(const double* diagonal, T rate, T explicitRate, double hopping, T* pivot, T* multiplier,
+                                         T* x, unsigned int size) {
+    const T coupling = rate * hopping;
+    const T explicitCoupling = explicitRate * hopping;
+    T previous = T(0);
+    T last = T(0);
+    for (unsigned int i = 0; i < size; ++i) {
+        const T current = x[i];
+        const T neighbours = i + 1 < size ? previous + x[i + 1] : previous;
+        const T rhs = (T(1) - explicitRate * diagonal[i]) * current - explicitCoupling * neighbours;
+        pivot[i] = T(1) / (T(1) + rate * diagonal[i] - coupling * coupling * last);
+        multiplier[i] = coupling * pivot[i];
+        x[i] = i > 0 ? rhs * pivot[i] - multiplier[i] * x[i - 1] : rhs * pivot[i];
+        last = pivot[i];
+        previous = current;
+    }
+    for (unsigned int i = size - 1; i-- > 0;) {
+        x[i] -= multiplier[i] * x[i + 1];
+    }
+}
+
+inline void stencilFactorizeAndPropagate(const double* diagonal, std::complex<double> rate, std::complex<double> explicitRate, double hopping,
+                                         std::complex<double>* pivot, std::complex<double>* multiplier, std::complex<double>* x,
+                                         unsigned int size) {
+    ComplexKernels::get().stencilFactorizeAndPropagate(diagonal, rate, explicitRate, hopping, pivot, multiplier, x, size);
+}
@@ -0,0 +1,93 @@
+#include "eigenbasis.h"
+
+#include <assert.h>
+#include <algorithm>
+#include <utility>
+
+namespace {
+const unsigned int RowBlock = 512;    //! The rows of the state which get reused for every block of eigenvectors
+const unsigned int MemberBlock = 256; //! The eigenvectors whose overlaps stay in the first level cache
+}
+
+Eigenbasis::Eigenbasis(const TridiagonalMatrix<std::complex<double>>& Hamiltonian, unsigned int Lowest, double Lower, double Upper, ThreadPool* pool)
+    : phases(Hamiltonian.getSize()), first(0) {
+    typedef TridiagonalMatrix<std::complex<double>> Matrix;
+    const unsigned int size = Hamiltonian.getSize();
+    const TridiagonalEigensolver solver = Hamiltonian.getEigensolver();
+
+    const std::pair<unsigned int, unsigned int> range = solver.window(Lower, Upper);
+    first = range.first;
+    const unsigned int count = Lowest > 0 ? std::min(Lowest, range.second - first) : range.second - first;
+    eigenvalues = solver.eigenvalues(first, count, pool);
+    eigenvectors = VectorBatch<double>(size, count);
+    solver.eigenvectors(eigenvalues, eigenvectors, pool);
+
+    // the symmetric form has the magnitudes of the off diagonal, so D carries their phases
+    std::complex<double> phase = 1.0;
+    phases[0] = 1.0;
+    for (unsigned int i = 0; i + 1 < size; ++i) {
+        const std::complex<double> element = Hamiltonian(Matrix::Lower, i);
+        const double magnitude = std::abs(element);
+        if (magnitude > 0) {
+            phase *= std::conj(element) / magnitude;
+        }
+        phases[i + 1] = std::conj(phase);
+    }
+}
+
+void Eigenbasis::project(const Vector<std::complex<double>>& state, std::complex<double>* overlaps, ThreadPool* pool) {
+    const unsigned int size = getSize();
+    const unsigned int count = getCount();
+    const unsigned int threads = pool ? pool->getThreadCount() : 1;
+    assert(state.size() == size);
+    sums.assign(2 * static_cast<size_t>(count) * threads, 0.0);
+
+    const auto accumulate = [&](unsigned int thread) {
+        const unsigned int begin = static_cast<unsigned int>(static_cast<unsigned long>(size) * thread / threads);
+        const unsigned int end = static_cast<unsigned int>(static_cast<unsigned long>(size) * (thread + 1) / threads);
+        double* real = sums.data() + 2 * static_cast<size_t>(count) * thread;
+        double* imag = real + count;
+        for (unsigned int rows = begin; rows < end; rows += RowBlock) {
+            const unsigned int rowsEnd = std::min(end, rows + RowBlock);
+            for (unsigned int members = 0; members < count; members += MemberBlock) {
+                const unsigned int length = std::min(MemberBlock, count - members);
+                double* re = real + members;
+                double* im = imag + members;
+                for (unsigned int i = rows; i < rowsEnd; ++i) {
+                    const std::complex<double> value = phases[i] * state[i];
+                    const double valueReal = value.real();
+                    const double valueImag = value.imag();
+                    const double* row = eigenvectors.row(i) + members;
+                    for (unsigned int n = 0; n < length; ++n) {
+                        re[n] += row[n] * valueReal;
+                        im[n] += row[n] * valueImag;
+                    }
+                }
+            }
+        }
+    };
+    if (threads == 1) {
+        accumulate(0);
+    } else {
+        pool->run(accumulate);
+    }
+
+    for (unsigned int n = 0; n < count; ++n) {
+        double re = 0;
+        double im = 0;
+        for (unsigned int thread = 0; thread < threads; ++thread) {
+            re += sums[2 * static_cast<size_t>(count) * thread + n];
+            im += sums[2 * static_cast<size_t>(count) * thread + count + n];
+        }
+        overlaps[n] = std::complex<double>(re, im);
+    }
+}
+
+Vector<std::complex<double>> Eigenbasis::getEigenvector(unsigned int n) const {
+    assert(n < getCount());
+    Vector<std::complex<double>> result(getSize());
+    for (unsigned int i = 0; i < getSize(); ++i) {
+        result[i] = std::conj(phases[i]) * eigenvectors(i, n);
+    }
+    return result;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <complex>
+#include <limits>
+#include <vector>
+
+#include "TridiagonalMatrix.h"
+#include "Vector.h"
+#include "VectorBatch.h"
+#include "threadpool.h"
+
+/**
+ * @brief The Eigenbasis class holds selected eigenstates \f$ \phi_n \f$ of a hermitian tridiagonal hamiltonian and projects
+ *        states onto them. The eigenvalues get found by TridiagonalEigensolver and the eigenvectors by inverse iteration on the
+ *        real symmetric form \f$ T = D^* H D \f$, where the diagonal matrix \f$ D \f$ holds the phases of the off diagonal.
+ *        The eigenvectors are stored as a VectorBatch, so all overlaps \f$ \langle\phi_n|\psi\rangle \f$ get computed in
+ *        a single pass over the state.
+ */
+class Eigenbasis
+{
+public:
+    /**
+     * @brief Eigenbasis Compute the eigenstates in an energy window.
+     * @param Hamiltonian The hermitian hamiltonian, e.g. of HamiltonianSolver::getHamiltonianMatrix.
+     * @param Lowest The count of the lowest eigenstates in the window, zero selects all of them.
+     * @param Lower The lower end of the energy window.
+     * @param Upper The upper end of the energy window, the eigenvalues in [Lower, Upper) get selected.
+     * @param pool The threads to distribute the eigenvalues and eigenvectors over or nullptr.
+     */
+    Eigenbasis(const TridiagonalMatrix<std::complex<double>>& Hamiltonian,
+               unsigned int Lowest,
+               double Lower = -std::numeric_limits<double>::infinity(),
+               double Upper = std::numeric_limits<double>::infinity(),
+               ThreadPool* pool = nullptr);
+
+    /**
+     * @brief #project Compute the overlaps of a state with all eigenstates.
+     *                 The rows get split into blocks which fit into the cache and the blocks get distributed over the pool.
+     * @param state The state \f$ \psi \f$ with getSize() elements.
+     * @param overlaps The array to write the getCount() overlaps \f$ \langle\phi_n|\psi\rangle \f$ into.
+     * @param pool The threads to distribute the rows over or nullptr.
+     */
+    void project(const Vector<std::complex<double>>& state, std::complex<double>* overlaps, ThreadPool* pool = nullptr);
+
+    /**
+     * @brief #getEigenvector Return a normalized eigenstate.
+     * @param n The index of the eigenstate in the selection.
+     * @return The eigenstate \f$ \phi_n \f$.
+     */
+    Vector<std::complex<double>> getEigenvector(unsigned int n) const;
+
+    /**
+     * @brief #getEigenvalues Return the eigenvalues of the selected eigenstates in accending order.
+     * @return The getCount() eigenvalues.
+     */
+    const std::vector<double>& getEigenvalues() const { return eigenvalues; }
+
+    /**
+     * @brief #getFirst Return the index of the first selected eigenstate in the whole spectrum.
+     * @return The index of \f$ \phi_0 \f$.
+     */
+    unsigned int getFirst() const { return first; }
+
+    /**
+     * @brief #getCount Return the count of selected eigenstates.
+     * @return The count of eigenstates.
+     */
+    unsigned int getCount() const { return static_cast<unsigned int>(eigenvalues.size()); }
+
+    /**
+     * @brief #getSize Return the size of the hamiltonian.
+     * @return The count of elements of the eigenstates.
+     */
+    unsigned int getSize() const { return static_cast<unsigned int>(phases.size()); }
+
+private:
+    VectorBatch<double> eigenvectors;               //! The eigenvectors of the real symmetric form
+    std::vector<std::complex<double>> phases;       //! The conjugated diagonal of \f$ D \f$
+    std::vector<double> eigenvalues;
+    std::vector<double> sums;                       //! The partial real and imaginary overlaps of every thread
+    unsigned int first;
+};
@@ -1,14 +1,22 @@
 #pragma once
 
+#include <algorithm>
+#include <limits>
 #include <ostream>
 #include <memory>
+#include <thread>
+#include <vector>
 
 #include "observable.h"
 #include "TridiagonalMatrix.h"
 #include "simulation.h"
+#include "threadpool.h"
 
 /**
- * @brief The EnergyEigenvalueObservable class
+ * @brief The EnergyEigenvalueObservable class writes the eigenvalues of the hamiltonian of the solver as lines "i E_i"
+ *        followed by an empty line. The eigenvalues can be restricted to an energy window and to the lowest few of them,
+ *        then they get found by Sturm bisection, see TridiagonalEigensolver, which is much cheaper than the whole
+ *        spectrum on large grids. The index i is always the index in the whole spectrum.
  */
 class EnergyEigenvalueObservable : public Observable
 {
@@ -16,9 +24,18 @@ public:
     /**
      * @brief construct a new Oberservable to filter the energy eigenvalues from the hamiltonian
      * @param output The stream to write the data into
+     * @param Lowest The count of the lowest eigenvalues in the window to write, zero writes all of them.
+     * @param Lower The lower end of the energy window.
+     * @param Upper The upper end of the energy window, the eigenvalues in [Lower, Upper) get written.
+     * @param Threads The count of threads to distribute the bisection over, zero uses all cores.
      */
-    EnergyEigenvalueObservable(std::ostream& output)
-        : Observable(Observable::Startup) {
+    EnergyEigenvalueObservable(std::ostream& output,
+                               unsigned int Lowest = 0,
+                               double Lower = -std::numeric_limits<double>::infinity(),
+                               double Upper = std::numeric_limits<double>::infinity(),
+                               unsigned int Threads = 0)
+        : Observable(Observable::Startup), lowest(Lowest), lower(Lower), upper(Upper),
+          threads(Threads > 0 ? Threads : std::max(1u, std::thread::hardware_concurrency())) {
         stream.reset(&output, [] (std::ostream* s) {});
     }
 
@@ -27,19 +44,20 @@ public:
      * @param sim The current simulation step
      */
     virtual void filter(const Simulation& sim) {
-        const ComplexTridiagonalMatrix ham = sim.getSolver()->getHamiltonianMatrix();
-        TridiagonalMatrix<double> mat(ham.getSize());
-        for (unsigned int i = 0; i < mat.getSize(); ++i) {
-            mat(TridiagonalMatrix<double>::Diagonal, i) = ham(ComplexTridiagonalMatrix::Diagonal, i).real();
-            mat(TridiagonalMatrix<double>::Upper, i) = ham(ComplexTridiagonalMatrix::Upper, i).real();
-            mat(TridiagonalMatrix<double>::Lower, i) = ham(ComplexTridiagonalMatrix::Lower, i).real();
+        if (!pool) {
+            pool.reset(new ThreadPool(threads));
         }
+        const TridiagonalEigensolver solver = sim.getSolver()->getHamiltonianMatrix().getEigensolver();
 
-        const Vector<double> eigenvalues = mat.getEigenvalues<double>();
+        const std::pair<unsigned int, unsigned int> range = solver.window(lower, upper);
+        const unsigned int first = range.first;
+        const unsigned int count = lowest > 0 ? std::min(lowest, range.second - first) : range.second - first;
+
+        const std::vector<double> eigenvalues = solver.eigenvalues(first, count, pool.get());
         for (unsigned int i = 0; i < eigenvalues.size(); ++i) {
-            (*stream.get()) << i
+            (*stream.get()) << first + i
                             << " "
-                            << eigenvalues(i)
+                            << eigenvalues[i]
                             << "\n";
         }
 
@@ -48,4 +66,9 @@ public:
 
 private:
     std::shared_ptr<std::ostream> stream;
+    std::unique_ptr<ThreadPool> pool;
+    unsigned int lowest;
+    double lower;
+    double upper;
+    unsigned int threads;
 };
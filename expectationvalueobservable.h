@@ -3,7 +3,7 @@
 #include <ostream>
 #include <memory>
 
-#include "TridiagonalMatrix.h"
+#include "Vector.h"
 #include "observable.h"
 #include "simulation.h"
 
@@ -18,17 +18,24 @@ public:
     ExpectationValueObservable(std::ostream& output)
         : Observable(Observable::Iteration) {
         stream.reset(&output, [] (std::ostream* s) {});
+        setSynchronous(true);
     }
 
     /**
-     * @brief #filter Filter the expectation value from the hamiltonian
+     * @brief #filter Filter the expectation value from the hamiltonian, the product with the hamiltonian
+     *                is written into a buffer, which is only allocated for the first frame
      * @param sim The current simulation step
      */
     virtual void filter(const Simulation& sim) {
-        const ComplexVector atoms = sim.getAtoms();
-        (*stream.get()) << sim.getIteration() << " " << sim.getSolver()->getHamiltonianMatrix().getExpectationValue(atoms).real() << "\n";
+        const ComplexVector& atoms = sim.getAtoms();
+        if (product.size() != atoms.size()) {
+            product = ComplexVector(atoms.size());
+        }
+        sim.getSolver()->applyHamiltonian(atoms, product);
+        (*stream.get()) << sim.getIteration() << " " << atoms.dot(product).real() << "\n";
     }
 
 private:
     std::shared_ptr<std::ostream> stream;
+    ComplexVector product; //! The hamiltonian applied to the atoms
 };
@@ -0,0 +1,378 @@
+#include "expression.h"
+
+#include <cmath>
+#include <cctype>
+#include <cstdlib>
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+const unsigned int BlockSize = 256;
+
+template <typename F>
+inline void unaryLoop(double* a, unsigned int size, F f) {
+    for (unsigned int i = 0; i < size; ++i) {
+        a[i] = f(a[i]);
+    }
+}
+
+template <typename F>
+inline void binaryLoop(double* a, const double* b, unsigned int size, F f) {
+    for (unsigned int i = 0; i < size; ++i) {
+        a[i] = f(a[i], b[i]);
+    }
+}
+
+}
+
+/**
+ * @brief The Expression::Parser class A recursive descent parser, which emits the instructions in postfix order:
+ *        comparison := sum (('<' | '>' | '<=' | '>=') sum)*
+ *        sum        := product (('+' | '-') product)*
+ *        product    := sign (('*' | '/') sign)*
+ *        sign       := ('-' | '+') sign | power
+ *        power      := primary ('^' sign)?
+ *        primary    := number | name | name '(' comparison (',' comparison)* ')' | '(' comparison ')'
+ */
+class Expression::Parser
+{
+public:
+    Parser(Expression& Target) : target(Target), text(Target.formula), pos(0) {
+    }
+
+    void parse() {
+        comparison();
+        skipSpace();
+        if (pos != text.size()) {
+            fail("unexpected character");
+        }
+    }
+
+private:
+    void comparison() {
+        sum();
+        for (;;) {
+            if (accept("<=")) {
+                sum();
+                target.emit(LessEqual);
+            } else if (accept(">=")) {
+                sum();
+                target.emit(GreaterEqual);
+            } else if (accept("<")) {
+                sum();
+                target.emit(Less);
+            } else if (accept(">")) {
+                sum();
+                target.emit(Greater);
+            } else {
+                return;
+            }
+        }
+    }
+
+    void sum() {
+        product();
+        for (;;) {
+            if (accept("+")) {
+                product();
+                target.emit(Add);
+            } else if (accept("-")) {
+                product();
+                target.emit(Subtract);
+            } else {
+                return;
+            }
+        }
+    }
+
+    void product() {
+        sign();
+        for (;;) {
+            if (accept("*")) {
+                sign();
+                target.emit(Multiply);
+            } else if (accept("/")) {
+                sign();
+                target.emit(Divide);
+            } else {
+                return;
+            }
+        }
+    }
+
+    void sign() {
+        if (accept("-")) {
+            sign();
+            target.emit(Negate);
+        } else if (accept("+")) {
+            sign();
+        } else {
+            power();
+        }
+    }
+
+    void power() {
+        primary();
+        if (accept("^")) {
+            sign();
+            target.emit(Power);
+        }
+    }
+
+    void primary() {
+        skipSpace();
+        if (pos >= text.size()) {
+            fail("unexpected end of the formula");
+        }
+        if (accept("(")) {
+            comparison();
+            expect(")");
+            return;
+        }
+        if (std::isdigit(static_cast<unsigned char>(text[pos])) || text[pos] == '.') {
+            const char* begin = text.c_str() + pos;
+            char* end = nullptr;
+            const double value = std::strtod(begin, &end);
+            if (end == begin) {
+                fail("invalid number");
+            }
+            pos += end - begin;
+            target.emit(Constant, value);
+            return;
+        }
+        if (!std::isalpha(static_cast<unsigned char>(text[pos]))) {
+            fail("expected a number, a variable or a function");
+        }
+
+        const size_t start = pos;
+        while (pos < text.size() && (std::isalnum(static_cast<unsigned char>(text[pos])) || text[pos] == '_')) {
+            ++pos;
+        }
+        const std::string name = text.substr(start, pos - start);
+        if (name == "x") {
+            target.emit(PositionX);
+        } else if (name == "t") {
+            target.emit(Time);
+        } else if (name == "pi") {
+            target.emit(Constant, std::acos(-1.0));
+        } else if (name == "e") {
+            target.emit(Constant, std::exp(1.0));
+        } else {
+            function(name, start);
+        }
+    }
+
+    void function(const std::string& name, size_t start) {
+        static const struct {
+            const char* name;
+            OpCode code;
+        } functions[] = {
+            { "sin", Sin }, { "cos", Cos }, { "tan", Tan }, { "exp", Exp }, { "log", Log }, { "sqrt", Sqrt },
+            { "abs", Abs }, { "floor", Floor }, { "min", Minimum }, { "max", Maximum }, { "pow", Power }
+        };
+        for (auto& it : functions) {
+            if (name == it.name) {
+                expect("(");
+                comparison();
+                if (!isUnary(it.code)) {
+                    expect(",");
+                    comparison();
+                }
+                expect(")");
+                target.emit(it.code);
+                return;
+            }
+        }
+        pos = start;
+        fail("unknown name '" + name + "'");
+    }
+
+    void skipSpace() {
+        while (pos < text.size() && std::isspace(static_cast<unsigned char>(text[pos]))) {
+            ++pos;
+        }
+    }
+
+    bool accept(const char* token) {
+        skipSpace();
+        const size_t length = std::char_traits<char>::length(token);
+        if (text.compare(pos, length, token) == 0) {
+            pos += length;
+            return true;
+        }
+        return false;
+    }
+
+    void expect(const char* token) {
+        if (!accept(token)) {
+            fail(std::string("expected '") + token + "'");
+        }
+    }
+
+    void fail(const std::string& message) const {
+        throw std::invalid_argument("invalid potential \"" + text + "\" at position " + std::to_string(pos) + ": " + message);
+    }
+
+    Expression& target;
+    const std::string& text;
+    size_t pos;
+};
+
+Expression::Expression(const std::string& Formula)
+    : formula(Formula), stackSize(0), timeDependent(false) {
+    Parser(*this).parse();
+
+    // the depth of the stack only grows with the operands
+    unsigned int depth = 0;
+    for (auto& it : program) {
+        if (it.code == Constant || it.code == PositionX || it.code == Time) {
+            stackSize = std::max(stackSize, ++depth);
+        } else if (!isUnary(it.code)) {
+            --depth;
+        }
+        timeDependent = timeDependent || it.code == Time;
+    }
+}
+
+double Expression::apply(OpCode code, double a, double b) {
+    switch (code) {
+    case Negate:       return -a;
+    case Square:       return a * a;
+    case Sin:          return std::sin(a);
+    case Cos:          return std::cos(a);
+    case Tan:          return std::tan(a);
+    case Exp:          return std::exp(a);
+    case Log:          return std::log(a);
+    case Sqrt:         return std::sqrt(a);
+    case Abs:          return std::abs(a);
+    case Floor:        return std::floor(a);
+    case Add:          return a + b;
+    case Subtract:     return a - b;
+    case Multiply:     return a * b;
+    case Divide:       return a / b;
+    case Power:        return std::pow(a, b);
+    case Less:         return a < b ? 1.0 : 0.0;
+    case Greater:      return a > b ? 1.0 : 0.0;
+    case LessEqual:    return a <= b ? 1.0 : 0.0;
+    case GreaterEqual: return a >= b ? 1.0 : 0.0;
+    case Minimum:      return std::min(a, b);
+    case Maximum:      return std::max(a, b);
+    default:           return a;
+    }
+}
+
+void Expression::emit(OpCode code, double value) {
+    // fold operations on constants into a single constant
+    const size_t size = program.size();
+    if (isUnary(code) && size >= 1 && program[size - 1].code == Constant) {
+        program[size - 1].value = apply(code, program[size - 1].value);
+        return;
+    }
+    if (code > Floor && size >= 2 && program[size - 1].code == Constant && program[size - 2].code == Constant) {
+        program[size - 2].value = apply(code, program[size - 2].value, program[size - 1].value);
+        program.pop_back();
+        return;
+    }
+    // the common square does not need the general power function
+    if (code == Power && size >= 1 && program[size - 1].code == Constant && program[size - 1].value == 2.0) {
+        program[size - 1].code = Square;
+        return;
+    }
+    Instruction instruction = { code, value };
+    program.push_back(instruction);
+}
+
+double Expression::operator () (double x, double t) const {
+    double result;
+    evaluate(&x, t, &result, 1);
+    return result;
+}
+
+void Expression::evaluate(const double* x, double t, double* result, unsigned int size) const {
+    Workspace workspace;
+    evaluate(x, t, result, size, workspace);
+}
+
+void Expression::evaluate(const double* x, double t, double* result, unsigned int size, Workspace& workspace) const {
+    if (workspace.uniform.size() < stackSize) {
+        workspace.stack.resize(stackSize * BlockSize);
+        workspace.scalar.resize(stackSize);
+        workspace.uniform.resize(stackSize);
+    }
+    // values which do not depend on the position, e.g. a drive sin(t), stay scalars until they meet a block
+    std::vector<double>& stack = workspace.stack;
+    std::vector<double>& scalar = workspace.scalar;
+    std::vector<char>& uniform = workspace.uniform;
+    for (unsigned int begin = 0; begin < size; begin += BlockSize) {
+        const unsigned int count = std::min(BlockSize, size - begin);
+        unsigned int depth = 0;
+        for (auto& it : program) {
+            if (it.code == Constant || it.code == Time) {
+                scalar[depth] = it.code == Time ? t : it.value;
+                uniform[depth++] = true;
+                continue;
+            }
+            if (it.code == PositionX) {
+                std::copy(x + begin, x + begin + count, stack.data() + depth * BlockSize);
+                uniform[depth++] = false;
+                continue;
+            }
+
+            if (isUnary(it.code) && uniform[depth - 1]) {
+                scalar[depth - 1] = apply(it.code, scalar[depth - 1]);
+                continue;
+            }
+            if (!isUnary(it.code) && uniform[depth - 1] && uniform[depth - 2]) {
+                scalar[depth - 2] = apply(it.code, scalar[depth - 2], scalar[depth - 1]);
+                --depth;
+                continue;
+            }
+            for (unsigned int k = isUnary(it.code) ? depth - 1 : depth - 2; k < depth; ++k) {
+                if (uniform[k]) {
+                    std::fill(stack.data() + k * BlockSize, stack.data() + k * BlockSize + count, scalar[k]);
+                    uniform[k] = false;
+                }
+            }
+
+            double* top = stack.data() + (depth - 1) * BlockSize;
+            switch (it.code) {
+            case Negate: unaryLoop(top, count, [](double a) { return -a; }); continue;
+            case Square: unaryLoop(top, count, [](double a) { return a * a; }); continue;
+            case Sin:    unaryLoop(top, count, [](double a) { return std::sin(a); }); continue;
+            case Cos:    unaryLoop(top, count, [](double a) { return std::cos(a); }); continue;
+            case Tan:    unaryLoop(top, count, [](double a) { return std::tan(a); }); continue;
+            case Exp:    unaryLoop(top, count, [](double a) { return std::exp(a); }); continue;
+            case Log:    unaryLoop(top, count, [](double a) { return std::log(a); }); continue;
+            case Sqrt:   unaryLoop(top, count, [](double a) { return std::sqrt(a); }); continue;
+            case Abs:    unaryLoop(top, count, [](double a) { return std::abs(a); }); continue;
+            case Floor:  unaryLoop(top, count, [](double a) { return std::floor(a); }); continue;
+            default:
+                break;
+            }
+
+            // binary operations combine the two topmost blocks
+            double* a = top - BlockSize;
+            --depth;
+            switch (it.code) {
+            case Add:          binaryLoop(a, top, count, [](double l, double r) { return l + r; }); break;
+            case Subtract:     binaryLoop(a, top, count, [](double l, double r) { return l - r; }); break;
+            case Multiply:     binaryLoop(a, top, count, [](double l, double r) { return l * r; }); break;
+            case Divide:       binaryLoop(a, top, count, [](double l, double r) { return l / r; }); break;
+            case Power:        binaryLoop(a, top, count, [](double l, double r) { return std::pow(l, r); }); break;
+            case Less:         binaryLoop(a, top, count, [](double l, double r) { return l < r ? 1.0 : 0.0; }); break;
+            case Greater:      binaryLoop(a, top, count, [](double l, double r) { return l > r ? 1.0 : 0.0; }); break;
+            case LessEqual:    binaryLoop(a, top, count, [](double l, double r) { return l <= r ? 1.0 : 0.0; }); break;
+            case GreaterEqual: binaryLoop(a, top, count, [](double l, double r) { return l >= r ? 1.0 : 0.0; }); break;
+            case Minimum:      binaryLoop(a, top, count, [](double l, double r) { return std::min(l, r); }); break;
+            case Maximum:      binaryLoop(a, top, count, [](double l, double r) { return std::max(l, r); }); break;
+            default:           break;
+            }
+        }
+        if (uniform[0]) {
+            std::fill(result + begin, result + begin + count, scalar[0]);
+        } else {
+            std::copy(stack.data(), stack.data() + count, result + begin);
+        }
+    }
+}
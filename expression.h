@@ -0,0 +1,99 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+/**
+ * @brief The Expression class compiles a formula string into a small stack program, which evaluates
+ *        a potential \f$ V(x, t) \f$ without calling back into python. The formula may use
+ *        - the variables x (the position in [0, 1]) and t (the simulation time),
+ *        - the constants pi and e and numbers like 1, 0.5 or 2e-3,
+ *        - the operators + - * / ^ and the comparisons < > <= >=, which result in 1 or 0,
+ *        - the functions sin, cos, tan, exp, log, sqrt, abs, floor, min, max and pow.
+ *        For example the potential well of scripts/potentialWell.py is "100 * ((x < 0.3) + (x > 0.6))".
+ *        Constant subexpressions get folded while compiling. The block evaluation runs every instruction
+ *        as a plain loop over many positions, so the compiler can vectorize it, subexpressions which only
+ *        depend on the time are evaluated once per block.
+ */
+class Expression
+{
+public:
+    /**
+     * @brief The Workspace struct The stack of a block evaluation, which can be reused for many evaluations.
+     */
+    struct Workspace {
+        std::vector<double> stack;  //! A block of values per stack entry
+        std::vector<double> scalar; //! The value of every stack entry which does not depend on the position
+        std::vector<char> uniform;  //! True if the stack entry is a scalar
+    };
+
+    /**
+     * @brief Expression Compile a formula.
+     * @param Formula The formula to compile.
+     * @throw std::invalid_argument if the formula is no valid expression.
+     */
+    explicit Expression(const std::string& Formula);
+
+    /**
+     * @brief #operator () Evaluate the expression at a single position.
+     * @param x The position.
+     * @param t The simulation time.
+     * @return The value of the expression.
+     */
+    double operator () (double x, double t = 0) const;
+
+    /**
+     * @brief #evaluate Evaluate the expression at many positions.
+     * @param x The positions.
+     * @param t The simulation time.
+     * @param result The array to write the values into, it may be the same as the positions.
+     * @param size The number of positions.
+     */
+    void evaluate(const double* x, double t, double* result, unsigned int size) const;
+
+    /**
+     * @brief #evaluate Evaluate the expression at many positions with a reusable stack.
+     *                  The workspace only grows on the first call, so repeated evaluations do not allocate.
+     * @param x The positions.
+     * @param t The simulation time.
+     * @param result The array to write the values into, it may be the same as the positions.
+     * @param size The number of positions.
+     * @param workspace The stack of the evaluation.
+     */
+    void evaluate(const double* x, double t, double* result, unsigned int size, Workspace& workspace) const;
+
+    /**
+     * @brief #dependsOnTime Return if the expression uses the variable t.
+     * @return True if the value changes with the simulation time.
+     */
+    bool dependsOnTime() const { return timeDependent; }
+
+    /**
+     * @brief #getFormula Return the compiled formula.
+     * @return The formula string.
+     */
+    const std::string& getFormula() const { return formula; }
+
+private:
+    enum OpCode {
+        Constant, PositionX, Time,
+        Negate, Square, Sin, Cos, Tan, Exp, Log, Sqrt, Abs, Floor,
+        Add, Subtract, Multiply, Divide, Power, Less, Greater, LessEqual, GreaterEqual, Minimum, Maximum
+    };
+
+    struct Instruction {
+        OpCode code;
+        double value; //! The value of a Constant
+    };
+
+    class Parser;
+
+    static bool isUnary(OpCode code) { return code >= Negate && code <= Floor; }
+    static double apply(OpCode code, double a, double b = 0);
+    void emit(OpCode code, double value = 0);
+
+    std::string formula;
+    std::vector<Instruction> program;
+    unsigned int stackSize;
+    bool timeDependent;
+};
@@ -0,0 +1 @@
+#include "feedbackhamiltonian.h"
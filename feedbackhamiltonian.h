@@ -0,0 +1,161 @@
+#pragma once
+
+#include <assert.h>
+#include <complex>
+#include <memory>
+#include <vector>
+#include "hamiltonian.h"
+#include "feedbackpotential.h"
+#include "StencilHamiltonian.h"
+#include "StencilPropagator.h"
+#include "PartitionedTridiagonalFactorization.h"
+#include "profiler.h"
+#include "SimulationParameter.h"
+
+/**
+ * @brief FeedbackHamiltonianSolver Schrödinger equation solver for a static potential plus state dependent feedbacks.
+ * The FeedbackHamiltonianSolver solves the Schrödinger equation with the form:
+ * \f[
+ *      (\frac{P^2}{2m} + V(r) + \sum_k F_k[x](r))|x(r, t)\rangle = i\hbar \frac{\delta}{\delta t}|x(r,t)\rangle
+ * \f]
+ * with the feedback potentials \f$ F_k \f$, which get evaluated on the state before every step like the
+ * NonLinearHamiltonianSolver does for its \f$ |x(r,t)|^2 \f$ term. Every step writes the feedbacks into a
+ * buffer, rewrites the diagonal of the StencilHamiltonian and factorizes and propagates in one sweep.
+ */
+template <typename T>
+class FeedbackHamiltonianSolver : public HamiltonianSolver<T>
+{
+public:
+    using HamiltonianSolver<T>::step;
+
+    /**
+     * @brief FeedbackHamiltonianSolver construct the solver from the SimulationParamter, a sampled potential and a feedback.
+     * @param Parameter The Parameter with time step and resolution.
+     * @param Potential The static potential at the positions \f$ i / N \f$ of the atoms.
+     * @param Feedback The first feedback potential or nullptr.
+     */
+    FeedbackHamiltonianSolver(SimulationParameter Parameter,
+                              const std::vector<double>& Potential,
+                              std::shared_ptr<FeedbackPotential<T>> Feedback = nullptr)
+        : parameter(Parameter), values(Parameter.atomCount) {
+        assert(Potential.size() == parameter.atomCount);
+        hamiltonian = StencilHamiltonian<T>(parameter.atomCount, -1.0);
+        potential.resize(parameter.atomCount);
+        for (unsigned int i = 0; i < parameter.atomCount; ++i) {
+            potential[i] = 2.0 + 2.0 * Potential[i];
+            hamiltonian(i) = potential[i];
+        }
+        if (Feedback) {
+            addFeedback(Feedback);
+        }
+    }
+
+    /**
+     * @brief #addFeedback Add a feedback potential, which gets evaluated every step.
+     * @param feedback The feedback potential.
+     */
+    void addFeedback(std::shared_ptr<FeedbackPotential<T>> feedback) {
+        assert(feedback);
+        feedbacks.push_back(feedback);
+    }
+
+    /**
+     * @brief #solve Solve the Equation for the wave function for the computed hamiltonian.
+     * @param current The current wave vector of the simulation.
+     * @return The new wave in the next timestep of the simulation.
+     */
+    virtual Vector<T> solve(const Vector<T>& current) override {
+        Vector<T> next(current);
+        updateDiagonal(current);
+        propagator.factorizeAndPropagate(hamiltonian, parameter.lambda, next);
+        return next;
+    }
+
+    /**
+     * @brief #step Propagate the wave function one timestep inplace without any allocation.
+     *              Large systems get partitioned over the threads of the workspace.
+     * @param state The current wave vector of the simulation, which gets replaced by the next timestep.
+     * @param workspace The preallocated buffers for the step.
+     */
+    virtual void step(Vector<T>& state, typename HamiltonianSolver<T>::Workspace& workspace) override {
+        updateDiagonal(state);
+        if (workspace.pool && PartitionedTridiagonalFactorization<T>::isSuitable(state.size(), workspace.pool->getThreadCount())) {
+            {
+                ProfileScope scope(Profiler::SolverAssemble);
+                if (left.getSize() != hamiltonian.getSize()) {
+                    hamiltonian.toCrankNicolson(left, parameter.lambda, 1.0);
+                    hamiltonian.toCrankNicolson(right, parameter.lambda, -1.0);
+                } else {
+                    hamiltonian.updateCrankNicolsonDiagonal(left, parameter.lambda, 1.0);
+                    hamiltonian.updateCrankNicolsonDiagonal(right, parameter.lambda, -1.0);
+                }
+            }
+            {
+                ProfileScope scope(Profiler::SolverFactorize);
+                partition.factorize(left, *workspace.pool);
+            }
+            ProfileScope scope(Profiler::SolverPropagate);
+            partition.propagate(right, state, *workspace.pool);
+        } else {
+            ProfileScope scope(Profiler::SolverPropagate);
+            propagator.factorizeAndPropagate(hamiltonian, parameter.lambda, state);
+        }
+    }
+
+    /**
+     * @brief #getHamiltonianMatrix Return the Hamilton matrix of the last step.
+     * @return The Hamilton matrix.
+     */
+    virtual TridiagonalMatrix<T> getHamiltonianMatrix() override {
+        return hamiltonian.toMatrix();
+    }
+
+    /**
+     * @brief #getLeftMatrix The left assigned matrix of the last step.
+     * @return The left assigned matrix.
+     */
+    virtual TridiagonalMatrix<T> getLeftMatrix() override {
+        TridiagonalMatrix<T> mat;
+        hamiltonian.toCrankNicolson(mat, parameter.lambda, 1.0);
+        return mat;
+    }
+
+    /**
+     * @brief #getRightMatrix The right assigned matrix of the last step.
+     * @return The right assigned matrix.
+     */
+    virtual TridiagonalMatrix<T> getRightMatrix() override {
+        TridiagonalMatrix<T> mat;
+        hamiltonian.toCrankNicolson(mat, parameter.lambda, -1.0);
+        return mat;
+    }
+
+private:
+    /**
+     * @brief #updateDiagonal Evaluate the feedbacks on the current state and rewrite the diagonal of the hamiltonian.
+     * @param current The current wave vector of the simulation.
+     */
+    void updateDiagonal(const Vector<T>& current) {
+        assert(current.size() == parameter.atomCount);
+        ProfileScope scope(Profiler::SolverPotential);
+        for (unsigned int i = 0; i < parameter.atomCount; ++i) {
+            hamiltonian(i) = potential[i];
+        }
+        for (auto& feedback : feedbacks) {
+            feedback->evaluate(current, values.data());
+            for (unsigned int i = 0; i < parameter.atomCount; ++i) {
+                hamiltonian(i) += 2.0 * values[i];
+            }
+        }
+    }
+
+    StencilHamiltonian<T> hamiltonian;
+    StencilPropagator<T> propagator;
+    TridiagonalMatrix<T> left;  //! Only built for the partitioned solve
+    TridiagonalMatrix<T> right; //! Only built for the partitioned solve
+    PartitionedTridiagonalFactorization<T> partition;
+    SimulationParameter parameter;
+    std::vector<double> potential; //! The diagonal of the hamiltonian without the feedbacks
+    std::vector<double> values;    //! The buffer for the feedbacks
+    std::vector<std::shared_ptr<FeedbackPotential<T>>> feedbacks;
+};
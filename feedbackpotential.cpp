@@ -0,0 +1 @@
+#include "feedbackpotential.h"
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <assert.h>
+#include <complex>
+
+#include "Vector.h"
+
+/**
+ * @brief FeedbackPotential Base class for potentials which depend on the current state of the simulation.
+ *        The solver evaluates the feedback once per step on the state before the step and adds it to the
+ *        static potential on the diagonal of the hamiltonian. Implementations write \f$ V_i[x] \f$ for every
+ *        atom into a buffer, so no state gets copied and no python gets called per atom.
+ */
+template <typename T>
+class FeedbackPotential
+{
+public:
+    virtual ~FeedbackPotential() {}
+
+    /**
+     * @brief #evaluate Compute the feedback potential for the current state.
+     * @param state A read only view of the current state.
+     * @param values The buffer to write the potential of every atom into, it holds state.size() elements.
+     */
+    virtual void evaluate(const Vector<T>& state, double* values) = 0;
+};
+
+/**
+ * @brief DensityFeedback The local density \f$ V_i = g |x_i|^2 \f$, the nonlinearity of the Gross Pitaevskii equation.
+ */
+template <typename T>
+class DensityFeedback : public FeedbackPotential<T>
+{
+public:
+    /**
+     * @brief DensityFeedback Construct the kernel.
+     * @param Factor The coupling \f$ g \f$.
+     */
+    DensityFeedback(double Factor) : factor(Factor) {
+    }
+
+    virtual void evaluate(const Vector<T>& state, double* values) override {
+        for (unsigned int i = 0; i < state.size(); ++i) {
+            values[i] = factor * std::norm(state[i]);
+        }
+    }
+
+private:
+    double factor;
+};
+
+/**
+ * @brief NeighbourDifferenceFeedback The coupling to the neighbouring amplitudes
+ *        \f$ V_i = g (|x_i - x_{i-1}|^2 + |x_i - x_{i+1}|^2) \f$, which is the phonon potential of scripts/phononPotential.py.
+ *        The first and the last atom get no feedback.
+ */
+template <typename T>
+class NeighbourDifferenceFeedback : public FeedbackPotential<T>
+{
+public:
+    /**
+     * @brief NeighbourDifferenceFeedback Construct the kernel.
+     * @param Factor The coupling \f$ g \f$.
+     */
+    NeighbourDifferenceFeedback(double Factor) : factor(Factor) {
+    }
+
+    virtual void evaluate(const Vector<T>& state, double* values) override {
+        const unsigned int size = state.size();
+        assert(size > 1);
+        values[0] = values[size - 1] = 0;
+        for (unsigned int i = 1; i < size - 1; ++i) {
+            values[i] = factor * (std::norm(state[i] - state[i - 1]) + std::norm(state[i] - state[i + 1]));
+        }
+    }
+
+private:
+    double factor;
+};
@@ -0,0 +1,107 @@
+#include "greenfunction.h"
+
+#include <assert.h>
+#include <cmath>
+
+namespace {
+const double Pi = std::acos(-1.0);
+}
+
+GreenFunction::GreenFunction(const TridiagonalMatrix<std::complex<double>>& Hamiltonian, double Broadening)
+    : diagonalLine(Hamiltonian.getSize()), coupling(Hamiltonian.getSize(), 0.0), broadening(Broadening) {
+    typedef TridiagonalMatrix<std::complex<double>> Matrix;
+    const unsigned int size = Hamiltonian.getSize();
+    assert(size > 0);
+    for (unsigned int i = 0; i < size; ++i) {
+        diagonalLine[i] = Hamiltonian(Matrix::Diagonal, i);
+    }
+    // the lower line holds the elements right of the diagonal and the upper line the elements left of it
+    for (unsigned int i = 0; i + 1 < size; ++i) {
+        coupling[i] = Hamiltonian(Matrix::Lower, i) * Hamiltonian(Matrix::Upper, i + 1);
+    }
+}
+
+std::complex<double> GreenFunction::operator () (double energy, unsigned int site) const {
+    assert(site < getSize());
+    const std::complex<double> z(energy, broadening);
+    const unsigned int size = getSize();
+
+    std::complex<double> left = z - diagonalLine[0];
+    for (unsigned int i = 1; i <= site; ++i) {
+        left = z - diagonalLine[i] - coupling[i - 1] / left;
+    }
+    if (site + 1 == size) {
+        return 1.0 / left;
+    }
+
+    std::complex<double> right = z - diagonalLine[size - 1];
+    for (unsigned int i = size - 1; i-- > site + 1;) {
+        right = z - diagonalLine[i] - coupling[i] / right;
+    }
+    return 1.0 / (left - coupling[site] / right);
+}
+
+void GreenFunction::element(const double* energies, unsigned int count, unsigned int site, std::complex<double>* result, ThreadPool* pool) const {
+    distribute(count, pool, [&](unsigned int first, unsigned int last) {
+        for (unsigned int e = first; e < last; ++e) {
+            result[e] = (*this)(energies[e], site);
+        }
+    });
+}
+
+void GreenFunction::diagonal(double energy, std::complex<double>* result, std::complex<double>* buffer) const {
+    const std::complex<double> z(energy, broadening);
+    const unsigned int size = getSize();
+
+    std::complex<double>* left = buffer;
+    left[0] = z - diagonalLine[0];
+    for (unsigned int i = 1; i < size; ++i) {
+        left[i] = z - diagonalLine[i] - coupling[i - 1] / left[i - 1];
+    }
+
+    // the backward recurrence joins the forward one at every atom
+    result[size - 1] = 1.0 / left[size - 1];
+    std::complex<double> right = z - diagonalLine[size - 1];
+    for (unsigned int i = size - 1; i-- > 0;) {
+        const std::complex<double> fraction = coupling[i] / right;
+        result[i] = 1.0 / (left[i] - fraction);
+        right = z - diagonalLine[i] - fraction;
+    }
+}
+
+void GreenFunction::localDensity(const double* energies, unsigned int count, double* result, ThreadPool* pool) const {
+    const unsigned int size = getSize();
+    distribute(count, pool, [&](unsigned int first, unsigned int last) {
+        if (first == last) {
+            return;
+        }
+        std::vector<std::complex<double>> buffer(size);
+        std::vector<std::complex<double>> values(size);
+        for (unsigned int e = first; e < last; ++e) {
+            diagonal(energies[e], values.data(), buffer.data());
+            double* row = result + static_cast<size_t>(e) * size;
+            for (unsigned int i = 0; i < size; ++i) {
+                row[i] = -values[i].imag() / Pi;
+            }
+        }
+    });
+}
+
+void GreenFunction::density(const double* energies, unsigned int count, double* result, ThreadPool* pool) const {
+    const unsigned int size = getSize();
+    distribute(count, pool, [&](unsigned int first, unsigned int last) {
+        if (first == last) {
+            return;
+        }
+        std::vector<std::complex<double>> buffer(size);
+        std::vector<std::complex<double>> values(size);
+        for (unsigned int e = first; e < last; ++e) {
+            diagonal(energies[e], values.data(), buffer.data());
+            double sum = 0;
+            for (unsigned int i = 0; i < size; ++i) {
+                sum += values[i].imag();
+            }
+            result[e] = -sum / Pi;
+        }
+    });
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <complex>
+#include <vector>
+
+#include "TridiagonalMatrix.h"
+#include "threadpool.h"
+
+/**
+ * @brief The GreenFunction class evaluates the resolvent \f$ G(E) = (E + i\eta - H)^{-1} \f$ of a tridiagonal hamiltonian.
+ *        The diagonal elements follow from the continued fractions of the chain left and right of an atom
+ * \f[
+ *      G_{ii}(z) = \frac{1}{z - H_{ii} - \frac{H_{i,i-1}H_{i-1,i}}{L_{i-1}} - \frac{H_{i,i+1}H_{i+1,i}}{R_{i+1}}}
+ * \f]
+ *        with the forward recurrence \f$ L_i = z - H_{ii} - H_{i,i-1}H_{i-1,i} / L_{i-1} \f$ and the backward recurrence
+ *        \f$ R_i = z - H_{ii} - H_{i,i+1}H_{i+1,i} / R_{i+1} \f$, so a single element and the whole diagonal cost
+ *        \f$ O(N) \f$ per energy. The energies are in the units of the hamiltonian matrix of the solver and the
+ *        broadening \f$ \eta > 0 \f$ keeps the recurrences away from the poles. Many energies get distributed over
+ *        the threads of a ThreadPool.
+ */
+class GreenFunction
+{
+public:
+    /**
+     * @brief GreenFunction Copy the lines of a hamiltonian.
+     * @param Hamiltonian The tridiagonal hamiltonian \f$ H \f$, e.g. of HamiltonianSolver::getHamiltonianMatrix.
+     * @param Broadening The imaginary part \f$ \eta \f$ of the energy.
+     */
+    GreenFunction(const TridiagonalMatrix<std::complex<double>>& Hamiltonian, double Broadening = 1e-3);
+
+    /**
+     * @brief #operator () Evaluate a single diagonal element.
+     * @param energy The energy \f$ E \f$.
+     * @param site The index \f$ i \f$ of the atom.
+     * @return The element \f$ G_{ii}(E + i\eta) \f$.
+     */
+    std::complex<double> operator () (double energy, unsigned int site) const;
+
+    /**
+     * @brief #element Evaluate a diagonal element for many energies.
+     * @param energies The energies.
+     * @param count The count of energies.
+     * @param site The index \f$ i \f$ of the atom.
+     * @param result The array to write the count elements \f$ G_{ii} \f$ into.
+     * @param pool The threads to distribute the energies over or nullptr.
+     */
+    void element(const double* energies, unsigned int count, unsigned int site, std::complex<double>* result, ThreadPool* pool = nullptr) const;
+
+    /**
+     * @brief #diagonal Evaluate the whole diagonal of the resolvent for an energy.
+     * @param energy The energy \f$ E \f$.
+     * @param result The array to write the getSize() elements \f$ G_{ii} \f$ into.
+     * @param buffer A buffer with getSize() elements for the forward recurrence.
+     */
+    void diagonal(double energy, std::complex<double>* result, std::complex<double>* buffer) const;
+
+    /**
+     * @brief #localDensity Evaluate the local density of states \f$ \rho_i(E) = -\frac{1}{\pi} \mathrm{Im}\, G_{ii}(E + i\eta) \f$.
+     * @param energies The energies.
+     * @param count The count of energies.
+     * @param result The array to write the density of every atom for every energy into, the row of an energy holds getSize() values.
+     * @param pool The threads to distribute the energies over or nullptr.
+     */
+    void localDensity(const double* energies, unsigned int count, double* result, ThreadPool* pool = nullptr) const;
+
+    /**
+     * @brief #density Evaluate the density of states \f$ \rho(E) = \sum_i \rho_i(E) \f$.
+     * @param energies The energies.
+     * @param count The count of energies.
+     * @param result The array to write the count densities into.
+     * @param pool The threads to distribute the energies over or nullptr.
+     */
+    void density(const double* energies, unsigned int count, double* result, ThreadPool* pool = nullptr) const;
+
+    /**
+     * @brief #getSize Return the count of atoms.
+     * @return The size of the hamiltonian.
+     */
+    unsigned int getSize() const { return static_cast<unsigned int>(diagonalLine.size()); }
+
+    /**
+     * @brief #getBroadening Return the imaginary part of the energy.
+     * @return The broadening \f$ \eta \f$.
+     */
+    double getBroadening() const { return broadening; }
+
+private:
+    /**
+     * @brief #distribute Call the function with a contiguous range of the energies on every thread of the pool.
+     * @param count The count of energies.
+     * @param pool The threads or nullptr to call the function once with all energies.
+     * @param function The callable with the first and the end index of the range.
+     */
+    template <typename Function>
+    static void distribute(unsigned int count, ThreadPool* pool, const Function& function) {
+        if (!pool || pool->getThreadCount() == 1 || count < 2) {
+            function(0u, count);
+            return;
+        }
+        const unsigned int threads = pool->getThreadCount();
+        pool->run([&](unsigned int thread) {
+            function(static_cast<unsigned int>(static_cast<unsigned long>(count) * thread / threads),
+                     static_cast<unsigned int>(static_cast<unsigned long>(count) * (thread + 1) / threads));
+        });
+    }
+
+    std::vector<std::complex<double>> diagonalLine; //! The main diagonal \f$ H_{ii} \f$
+    std::vector<std::complex<double>> coupling;     //! The products \f$ H_{i,i+1}H_{i+1,i} \f$ of the off diagonals
+    double broadening;
+};
@@ -0,0 +1 @@
+#include "greenfunctionobservable.h"
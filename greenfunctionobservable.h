@@ -0,0 +1,111 @@
+#pragma once
+
+#include <algorithm>
+#include <complex>
+#include <memory>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+#include "observable.h"
+#include "simulation.h"
+#include "greenfunction.h"
+#include "threadpool.h"
+
+/**
+ * @brief The GreenFunctionObservable class evaluates the Green function of the hamiltonian of the solver for a sweep of energies,
+ *        see GreenFunction. The energies get distributed over a pool of threads and the output depends on the quantity:
+ *        - Element writes a line "E |G| Re(G) Im(G)" per energy for the diagonal element \f$ G_{ii} \f$ of one atom,
+ *        - LocalDensity writes a block of lines "E x rho" per energy with the local density of states of every atom,
+ *        - Density writes a line "E rho" per energy with the density of states.
+ *        Every filter call ends with an empty line, like the other observables.
+ */
+class GreenFunctionObservable : public Observable
+{
+public:
+    /**
+     * @brief The Quantity enum selects what gets written for every energy.
+     */
+    enum Quantity {
+        Element = 0,      //! The diagonal element \f$ G_{ii}(E + i\eta) \f$ of a single atom
+        LocalDensity = 1, //! The local density of states \f$ \rho_i(E) \f$ of every atom
+        Density = 2       //! The density of states \f$ \rho(E) \f$
+    };
+
+    /**
+     * @brief GreenFunctionObservable Construct a new observable for a sweep of energies.
+     * @param output The stream to write the data into.
+     * @param Energies The energies in the units of the hamiltonian matrix.
+     * @param Mode The quantity to write.
+     * @param Site The index of the atom for the Element quantity.
+     * @param Broadening The imaginary part \f$ \eta \f$ of the energies.
+     * @param Threads The count of threads to distribute the energies over, zero uses all cores.
+     * @param Time The time to filter at, the hamiltonian of a time dependent solver changes with every step.
+     */
+    GreenFunctionObservable(std::ostream& output,
+                            const std::vector<double>& Energies,
+                            Quantity Mode = Element,
+                            unsigned int Site = 1,
+                            double Broadening = 1e-3,
+                            unsigned int Threads = 0,
+                            CheckTime Time = Observable::Startup)
+        : Observable(Time), energies(Energies), mode(Mode), site(Site), broadening(Broadening),
+          threads(Threads > 0 ? Threads : std::max(1u, std::thread::hardware_concurrency())) {
+        stream.reset(&output, [] (std::ostream* s) {});
+        setSynchronous(true);
+    }
+
+    /**
+     * @brief #filter Evaluate the Green function of the current hamiltonian for all energies.
+     * @param sim The current simulation step.
+     */
+    virtual void filter(const Simulation& sim) {
+        if (!pool) {
+            pool.reset(new ThreadPool(threads));
+        }
+        const GreenFunction green(sim.getSolver()->getHamiltonianMatrix(), broadening);
+        const unsigned int count = static_cast<unsigned int>(energies.size());
+        std::ostream& out = *stream.get();
+
+        if (mode == Element) {
+            std::vector<std::complex<double>> values(count);
+            green.element(energies.data(), count, std::min(site, green.getSize() - 1), values.data(), pool.get());
+            for (unsigned int e = 0; e < count; ++e) {
+                out << energies[e] << " " << std::abs(values[e]) << " " << values[e].real() << " " << values[e].imag() << "\n";
+            }
+        } else if (mode == Density) {
+            std::vector<double> values(count);
+            green.density(energies.data(), count, values.data(), pool.get());
+            for (unsigned int e = 0; e < count; ++e) {
+                out << energies[e] << " " << values[e] << "\n";
+            }
+        } else {
+            // the densities of all energies may not fit into memory, so they get evaluated in blocks
+            const unsigned int size = green.getSize();
+            const unsigned int block = std::max(threads, (1u << 22) / size);
+            std::vector<double> values(static_cast<size_t>(std::min(block, count)) * size);
+            for (unsigned int first = 0; first < count; first += block) {
+                const unsigned int length = std::min(block, count - first);
+                green.localDensity(energies.data() + first, length, values.data(), pool.get());
+                for (unsigned int e = 0; e < length; ++e) {
+                    const double* row = values.data() + static_cast<size_t>(e) * size;
+                    for (unsigned int i = 0; i < size; ++i) {
+                        out << energies[first + e] << " " << static_cast<double>(i) / size << " " << row[i] << "\n";
+                    }
+                    out << "\n";
+                }
+            }
+        }
+
+        out << "\n";
+    }
+
+private:
+    std::shared_ptr<std::ostream> stream;
+    std::unique_ptr<ThreadPool> pool;
+    std::vector<double> energies;
+    Quantity mode;
+    unsigned int site;
+    double broadening;
+    unsigned int threads;
+};
@@ -1,6 +1,11 @@
 #pragma once
 
+#include <vector>
+#include <functional>
+
+#include "VectorBatch.h"
 #include "TridiagonalMatrix.h"
+#include "threadpool.h"
 
 /**
  * @brief HamiltonianSolver Base class for the equation solver.
@@ -26,6 +31,24 @@ template <typename T>
 class HamiltonianSolver
 {
 public:
+    /**
+     * @brief The Workspace struct holds the buffers which a solver may use during a step.
+     *        It gets allocated once before the simulation loop and is reused for every step.
+     */
+    struct Workspace {
+        /**
+         * @brief Workspace Construct a workspace for states with the given size.
+         * @param Size The number of elements of the state.
+         * @param Members The number of states which get propagated together in a VectorBatch.
+         */
+        Workspace(unsigned int Size, unsigned int Members = 1) : buffer(Size), row(Members), pool(nullptr) {
+        }
+
+        Vector<T> buffer; //! A temporary vector with the size of the state, used by the default batch step
+        Vector<T> row;    //! A temporary vector with one element per member of a batch
+        ThreadPool* pool; //! The threads a solver may use for the step or nullptr to solve sequentially
+    };
+
     /**
      * @brief HamiltonianSolver Default constructor does nothing
      */
@@ -39,12 +62,74 @@ public:
      */
     virtual Vector<T> solve(const Vector<T>& current) = 0;
 
+    /**
+     * @brief #step Propagate the wave function one timestep inplace.
+     *              The default implementation calls #solve, solvers which are able to work
+     *              in the given workspace should override this to avoid any allocation.
+     * @param state The current wave vector of the simulation, which gets replaced by the next timestep.
+     * @param workspace The preallocated buffers for the step.
+     */
+    virtual void step(Vector<T>& state, Workspace& /*workspace*/) {
+        state = solve(state);
+    }
+
+    /**
+     * @brief #step Propagate all states of a batch one timestep inplace.
+     *              The default implementation steps every member on its own through the workspace buffer,
+     *              solvers with a state independent left matrix should override this to share its factorization.
+     * @param states The current wave vectors, which get replaced by the next timestep.
+     * @param workspace The preallocated buffers for the step.
+     */
+    virtual void step(VectorBatch<T>& states, Workspace& workspace) {
+        for (unsigned int j = 0; j < states.getMemberCount(); ++j) {
+            states.getMember(j, workspace.buffer);
+            step(workspace.buffer, workspace);
+            states.setMember(j, workspace.buffer);
+        }
+    }
+
+    /**
+     * @brief #setImaginaryTime Switch the solver between real time and imaginary time steps.
+     *                          In imaginary time the time step \f$ \Delta t \f$ is replaced by \f$ -i\tau \f$,
+     *                          so every step damps the states with high energies, see Simulation::relax.
+     * @param lambda The \f$ \lambda \f$ of the imaginary time step \f$ \tau \f$ or zero to return to real time.
+     * @return False if the solver does not support imaginary time.
+     */
+    virtual bool setImaginaryTime(double lambda) {
+        return lambda == 0;
+    }
+
+    /**
+     * @brief #applyHamiltonian Multiply a state with the hamiltonian of the solver.
+     *                          The default implementation builds the hamilton matrix, solvers should override this
+     *                          to avoid the allocation. Nonlinear solvers use the hamiltonian of the given state.
+     * @param state The state \f$ x \f$.
+     * @param result The vector to write \f$ Hx \f$ into, it must have the size of the state.
+     */
+    virtual void applyHamiltonian(const Vector<T>& state, Vector<T>& result) {
+        getHamiltonianMatrix().multiply(state, result);
+    }
+
     /**
      * @brief #getHamiltonianMatrix Return the used hamilton matrix.
      * @return The hamilton matrix.
      */
     virtual TridiagonalMatrix<T> getHamiltonianMatrix() = 0;
 
+    /**
+     * @brief #samplePotential Sample a potential function at the positions of the atoms.
+     * @param potentialFunction The potential function of the form \f$ f:[0,1]\rightarrow\mathbb{R} \f$.
+     * @param atomCount The atom count in the simulation.
+     * @return The values \f$ f(i / N) \f$ for every atom \f$ i \f$.
+     */
+    static std::vector<double> samplePotential(const std::function<double (double)>& potentialFunction, unsigned int atomCount) {
+        std::vector<double> samples(atomCount);
+        for (unsigned int i = 0; i < atomCount; ++i) {
+            samples[i] = potentialFunction(static_cast<double>(i) / atomCount);
+        }
+        return samples;
+    }
+
     /**
      * @brief #getLeftMatrix The left assigned matrix which may be used in the simulation.
      * @return The left assigned matrix.
@@ -0,0 +1,144 @@
+#include "jobscheduler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <iostream>
+#include <new>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#define JOBSCHEDULER_FORK 1
+#endif
+
+namespace {
+
+/**
+ * @brief The JobState enum marks the progress of a job in the shared memory.
+ */
+enum JobState : unsigned char {
+    Pending = 0,
+    Running = 1,
+    Finished = 2,
+    Failed = 3
+};
+
+/**
+ * @brief The SharedQueue struct lives in memory which is shared between the forked workers.
+ */
+struct SharedQueue {
+    std::atomic<unsigned int> next;
+    unsigned char state[1];
+};
+
+bool execute(const std::function<void (unsigned int)>& job, unsigned int index) {
+    try {
+        job(index);
+        return true;
+    } catch (std::exception& e) {
+        std::cerr << "job " << index << " failed: " << e.what() << std::endl;
+    } catch (...) {
+        std::cerr << "job " << index << " failed" << std::endl;
+    }
+    return false;
+}
+
+}
+
+JobScheduler::JobScheduler(unsigned int Workers) : workerCount(Workers > 0 ? Workers : 1) {
+}
+
+unsigned int JobScheduler::run(const std::vector<double>& costs, const std::function<void (unsigned int)>& job) {
+    std::vector<unsigned int> order(costs.size());
+    for (unsigned int i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+
+#ifdef JOBSCHEDULER_FORK
+    if (workerCount > 1 && order.size() > 1) {
+        std::stable_sort(order.begin(), order.end(), [&costs](unsigned int a, unsigned int b) {
+            return costs[a] > costs[b];
+        });
+        return runForked(order, job);
+    }
+#endif
+    return runSequential(order, job);
+}
+
+unsigned int JobScheduler::runSequential(const std::vector<unsigned int>& order, const std::function<void (unsigned int)>& job) {
+    unsigned int failed = 0;
+    for (unsigned int index : order) {
+        if (!execute(job, index)) {
+            ++failed;
+        }
+    }
+    return failed;
+}
+
+unsigned int JobScheduler::runForked(const std::vector<unsigned int>& order, const std::function<void (unsigned int)>& job) {
+#ifdef JOBSCHEDULER_FORK
+    const size_t bytes = sizeof(SharedQueue) + order.size();
+    void* memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        std::cerr << "could not map shared memory, run the jobs sequentially" << std::endl;
+        return runSequential(order, job);
+    }
+    SharedQueue* queue = new (memory) SharedQueue;
+    queue->next.store(0);
+    std::fill(queue->state, queue->state + order.size(), static_cast<unsigned char>(Pending));
+
+    // buffered output would be written by the parent and every worker
+    std::cout.flush();
+    std::cerr.flush();
+
+    const unsigned int workers = std::min<unsigned int>(workerCount, static_cast<unsigned int>(order.size()));
+    std::vector<pid_t> children;
+    for (unsigned int w = 0; w < workers; ++w) {
+        const pid_t pid = fork();
+        if (pid == 0) {
+            unsigned int slot;
+            while ((slot = queue->next.fetch_add(1)) < order.size()) {
+                queue->state[slot] = Running;
+                queue->state[slot] = execute(job, order[slot]) ? Finished : Failed;
+            }
+            std::cout.flush();
+            std::cerr.flush();
+            _exit(0);
+        } else if (pid > 0) {
+            children.push_back(pid);
+        } else {
+            std::cerr << "could not fork worker " << w << std::endl;
+        }
+    }
+
+    if (children.empty()) {
+        munmap(memory, bytes);
+        return runSequential(order, job);
+    }
+
+    for (pid_t pid : children) {
+        int status = 0;
+        while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {
+        }
+    }
+
+    unsigned int failed = 0;
+    for (unsigned int slot = 0; slot < order.size(); ++slot) {
+        if (queue->state[slot] == Pending) {
+            // all workers died before the job was taken
+            failed += execute(job, order[slot]) ? 0 : 1;
+        } else if (queue->state[slot] == Running) {
+            std::cerr << "job " << order[slot] << " did not finish, its worker died" << std::endl;
+            ++failed;
+        } else if (queue->state[slot] == Failed) {
+            ++failed;
+        }
+    }
+    munmap(memory, bytes);
+    return failed;
+#else
+    return runSequential(order, job);
+#endif
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <vector>
+#include <functional>
+
+/**
+ * @brief The JobScheduler class runs independent jobs on a fixed number of worker processes.
+ *        The workers get forked from the calling process, so every job has its own python
+ *        interpreter and global interpreter lock. The jobs are sorted by their estimated cost and
+ *        every worker takes the next open job from a counter in shared memory as soon as it is idle,
+ *        so a few long jobs do not leave the other workers waiting on a static partition.
+ *        On platforms without fork or with a single worker the jobs run in the calling process.
+ */
+class JobScheduler
+{
+public:
+    /**
+     * @brief JobScheduler Construct a scheduler.
+     * @param Workers The number of jobs which may run at the same time.
+     */
+    JobScheduler(unsigned int Workers);
+
+    /**
+     * @brief #run Execute all jobs and wait for them.
+     * @param costs The estimated cost of every job, with multiple workers the most expensive jobs get started first.
+     * @param job The callable which executes the job with the given index.
+     * @return The number of jobs which threw an exception or whose worker died before they finished.
+     */
+    unsigned int run(const std::vector<double>& costs, const std::function<void (unsigned int)>& job);
+
+    /**
+     * @brief #getWorkerCount Return the number of jobs which may run at the same time.
+     * @return The number of workers.
+     */
+    unsigned int getWorkerCount() const { return workerCount; }
+
+private:
+    unsigned int runSequential(const std::vector<unsigned int>& order, const std::function<void (unsigned int)>& job);
+    unsigned int runForked(const std::vector<unsigned int>& order, const std::function<void (unsigned int)>& job);
+
+    unsigned int workerCount;
+};
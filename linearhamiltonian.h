@@ -1,8 +1,14 @@
 #pragma once
 
+#include <assert.h>
 #include <complex>
 #include <functional>
+#include <vector>
 #include "hamiltonian.h"
+#include "StencilHamiltonian.h"
+#include "StencilPropagator.h"
+#include "PartitionedTridiagonalFactorization.h"
+#include "profiler.h"
 
 #include "SimulationParameter.h"
 #include "utilitys.h"
@@ -26,6 +32,9 @@
  * \f[
  *      Right := 1 - \frac{i\Delta t}{2h} H
  * \f]
+ * The hamiltonian is kept as a StencilHamiltonian, so the left and right matrices are never stored
+ * and only get built on request or for the partitioned solve of large systems.
+ * In imaginary time the left matrix \f$ 1 + 2\lambda H \f$ of the implicit Euler step is constant as well and gets factorized once.
  */
 template <typename T>
 class LinearHamiltonianSolver : public HamiltonianSolver<T>
@@ -39,28 +48,93 @@ public:
      */
     LinearHamiltonianSolver(SimulationParameter Parameter,
                             std::function<double (double)> PotentialFunction)
-        : parameter(Parameter), potentialFunction(PotentialFunction) {
+        : LinearHamiltonianSolver(Parameter, HamiltonianSolver<T>::samplePotential(PotentialFunction, Parameter.atomCount)) {
+        potentialFunction = PotentialFunction;
+    }
 
-        hamiltonian = TridiagonalMatrix<T>(parameter.atomCount);
+    /**
+     * @brief LinearHamiltonianSolver construct the Hamiltonian matrix from the SimulationParamter and a sampled potential.
+     *                                This allows simulations on the same grid to share the sampling of the potential.
+     * @param Parameter The Parameter with time step and resolution
+     * @param Potential The potential at the positions \f$ i / N \f$ of the atoms.
+     */
+    LinearHamiltonianSolver(SimulationParameter Parameter,
+                            const std::vector<double>& Potential)
+        : parameter(Parameter), imaginaryLambda(0) {
+        assert(Potential.size() == parameter.atomCount);
+        hamiltonian = StencilHamiltonian<T>(parameter.atomCount, -1.0);
         for (unsigned int i = 0; i < parameter.atomCount; ++i) {
-            hamiltonian(TridiagonalMatrix<T>::Lower, i) = std::complex<double>(-1.0, 0);
-            hamiltonian(TridiagonalMatrix<T>::Diagonal, i) = std::complex<double>( 2.0 + 2.0 * potentialFunction(static_cast<double>(i) / parameter.atomCount), 0);
-            hamiltonian(TridiagonalMatrix<T>::Upper, i) = std::complex<double>(-1.0, 0);
+            hamiltonian(i) = 2.0 + 2.0 * Potential[i];
         }
-
-        left = TridiagonalMatrix<T>::identity(parameter.atomCount, std::complex<double>(1.0, 0)) +
-                hamiltonian * std::complex<double>(0, parameter.lambda);
-        right = TridiagonalMatrix<T>::identity(parameter.atomCount, std::complex<double>(1.0, 0)) -
-                hamiltonian * std::complex<double>(0, parameter.lambda);
+        propagator.factorize(hamiltonian, parameter.lambda);
     }
 
     /**
      * @brief #solve Solve the equation for the wave function for the computed hamiltonian.
+     *               The left matrix is constant, so only the substitution of its factorization is done per step.
      * @param current The current wave vector of the simulation.
      * @return The new wave in the next timestep of the simulation.
      */
     virtual Vector<T> solve(const Vector<T>& current) override {
-        return getLeftMatrix().solve(getRightMatrix() * current);
+        Vector<T> next(current);
+        propagator.propagate(hamiltonian, next);
+        return next;
+    }
+
+    /**
+     * @brief #step Propagate the wave function one timestep inplace without any allocation.
+     *              Large systems get partitioned over the threads of the workspace.
+     * @param state The current wave vector of the simulation, which gets replaced by the next timestep.
+     * @param workspace The preallocated buffers for the step.
+     */
+    virtual void step(Vector<T>& state, typename HamiltonianSolver<T>::Workspace& workspace) override {
+        if (imaginaryLambda == 0 && workspace.pool && PartitionedTridiagonalFactorization<T>::isSuitable(state.size(), workspace.pool->getThreadCount())) {
+            if (partition.getBlockCount() != workspace.pool->getThreadCount()) {
+                {
+                    ProfileScope scope(Profiler::SolverAssemble);
+                    hamiltonian.toCrankNicolson(left, parameter.lambda, 1.0);
+                    hamiltonian.toCrankNicolson(right, parameter.lambda, -1.0);
+                }
+                ProfileScope scope(Profiler::SolverFactorize);
+                partition.factorize(left, *workspace.pool);
+            }
+            ProfileScope scope(Profiler::SolverPropagate);
+            partition.propagate(right, state, *workspace.pool);
+        } else {
+            ProfileScope scope(Profiler::SolverPropagate);
+            propagator.propagate(hamiltonian, state);
+        }
+    }
+
+    /**
+     * @brief #step Propagate all states of a batch one timestep inplace with the shared factorization.
+     * @param states The current wave vectors, which get replaced by the next timestep.
+     * @param workspace The preallocated buffers for the step.
+     */
+    virtual void step(VectorBatch<T>& states, typename HamiltonianSolver<T>::Workspace& workspace) override {
+        ProfileScope scope(Profiler::SolverPropagate);
+        propagator.propagate(hamiltonian, states, workspace.row);
+    }
+
+    /**
+     * @brief #setImaginaryTime Switch between real time and imaginary time steps and refactorize the left matrix.
+     *                          Imaginary time steps are always solved on a single thread.
+     * @param lambda The \f$ \lambda \f$ of the imaginary time step or zero to return to real time.
+     * @return True, the solver supports imaginary time.
+     */
+    virtual bool setImaginaryTime(double lambda) override {
+        imaginaryLambda = lambda;
+        propagator.factorize(hamiltonian, lambda != 0 ? lambda : parameter.lambda, lambda != 0);
+        return true;
+    }
+
+    /**
+     * @brief #applyHamiltonian Multiply a state with the hamiltonian without building the matrix.
+     * @param state The state \f$ x \f$.
+     * @param result The vector to write \f$ Hx \f$ into.
+     */
+    virtual void applyHamiltonian(const Vector<T>& state, Vector<T>& result) override {
+        hamiltonian.multiply(state, result);
     }
 
     /**
@@ -68,7 +142,7 @@ public:
      * @return The Hamilton Matrix.
      */
     virtual TridiagonalMatrix<T> getHamiltonianMatrix() override {
-        return hamiltonian;
+        return hamiltonian.toMatrix();
     }
 
     /**
@@ -76,7 +150,9 @@ public:
      * @return The left assigned Matrix.
      */
     virtual TridiagonalMatrix<T> getLeftMatrix() override {
-        return left;
+        TridiagonalMatrix<T> mat;
+        hamiltonian.toCrankNicolson(mat, parameter.lambda, 1.0);
+        return mat;
     }
 
     /**
@@ -84,14 +160,19 @@ public:
      * @return The right assigned matrix.
      */
     virtual TridiagonalMatrix<T> getRightMatrix() override {
-        return right;
+        TridiagonalMatrix<T> mat;
+        hamiltonian.toCrankNicolson(mat, parameter.lambda, -1.0);
+        return mat;
     }
 
 private:
-    TridiagonalMatrix<T> hamiltonian;
-    TridiagonalMatrix<T> left;
-    TridiagonalMatrix<T> right;
+    StencilHamiltonian<T> hamiltonian;
+    StencilPropagator<T> propagator;
+    TridiagonalMatrix<T> left;  //! Only built for the partitioned solve
+    TridiagonalMatrix<T> right; //! Only built for the partitioned solve
+    PartitionedTridiagonalFactorization<T> partition;
 
     std::function<double (double)> potentialFunction;
     SimulationParameter parameter;
+    double imaginaryLambda; //! The \f$ \lambda \f$ of the imaginary time step, zero in real time
 };
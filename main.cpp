@@ -9,6 +9,8 @@
 #include <boost/token_functions.hpp>
 
 #include "simulationexecutor.h"
+#include "profiler.h"
+#include "trajectory.h"
 #include "TridiagonalMatrix.h"
 
 using namespace boost;
@@ -24,7 +26,13 @@ int main(int argc, char** argv) {
     );
     desc.add_options()
             ("help,h", "Show this help text")
-            ("files,f", value<std::vector<std::string>>(), "Simulation files");
+            ("files,f", value<std::vector<std::string>>(), "Simulation files")
+            ("jobs,j", value<unsigned int>()->default_value(1), "Number of simulations which run at the same time in separate processes")
+            ("convert,c", value<std::string>(), "Convert a binary trajectory into the gnuplot text layout")
+            ("channel", value<std::string>()->default_value("amplitude"), "The channel to convert: amplitude, real or imaginary")
+            ("output,o", value<std::string>(), "The text file to write the converted trajectory into, default is stdout")
+            ("profile", value<std::string>(), "Measure the stages of the simulations and write a JSON summary into the file")
+            ("trace", value<std::string>(), "Write the measured stages as a Chrome trace into the file, implies the profiling");
 
     variables_map vm;
     try {
@@ -39,12 +47,41 @@ int main(int argc, char** argv) {
         desc.print(std::cout);
     }
 
+    if (vm.count("convert")) {
+        const std::string channelName = vm["channel"].as<std::string>();
+        Trajectory::Channel channel;
+        if (channelName == "amplitude") {
+            channel = Trajectory::Amplitude;
+        } else if (channelName == "real") {
+            channel = Trajectory::Real;
+        } else if (channelName == "imaginary") {
+            channel = Trajectory::Imaginary;
+        } else {
+            std::cerr << "unknown channel " << channelName << ", use amplitude, real or imaginary" << std::endl;
+            return 1;
+        }
+        try {
+            TrajectoryReader reader(vm["convert"].as<std::string>());
+            if (vm.count("output")) {
+                std::ofstream output(vm["output"].as<std::string>().c_str());
+                reader.writeGnuplot(output, channel);
+            } else {
+                reader.writeGnuplot(std::cout, channel);
+            }
+        } catch (std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+    }
+
+    if (vm.count("profile") || vm.count("trace")) {
+        Profiler::get().enable(vm.count("profile") ? vm["profile"].as<std::string>() : "",
+                               vm.count("trace") ? vm["trace"].as<std::string>() : "");
+    }
+
     if (vm.count("files")) {
         std::vector<std::string> files = vm["files"].as<std::vector<std::string>>();
-        for (auto file : files) {
-            std::cout << "process file: " << file << std::endl;
-            SimulationExecutor(file.c_str()); //only call constructor
-        }
+        SimulationExecutor(files, vm["jobs"].as<unsigned int>()); //only call constructor
     }
 
     return 0;
@@ -1,8 +1,14 @@
 #pragma once
 
+#include <assert.h>
 #include <complex>
 #include <functional>
+#include <vector>
 #include "hamiltonian.h"
+#include "StencilHamiltonian.h"
+#include "StencilPropagator.h"
+#include "PartitionedTridiagonalFactorization.h"
+#include "profiler.h"
 #include "SimulationParameter.h"
 
 /**
@@ -25,33 +31,62 @@
  * \f[
  *      Right := 1 - \frac{i\Delta t}{2} H
  * \f]
+ * Only the main diagonal depends on the wave function, so the potential gets sampled once and every
+ * step rewrites the diagonal of the StencilHamiltonian in a single pass, then factorizes and propagates
+ * in one sweep. The left and right matrices are never stored, except for the partitioned solve of large systems.
+ * In imaginary time the state gets renormalized after every step, so with the Global nonlinearity the diagonal
+ * stays the same and the left matrix \f$ 1 + 2\lambda H \f$ only gets factorized when the norm changes.
  */
 template <typename T>
 class NonLinearHamiltonianSolver : public HamiltonianSolver<T>
 {
 public:
+    using HamiltonianSolver<T>::step;
+
+    /**
+     * @brief The NonLinearity enum selects how the \f$ |x(r,t)|^2 \f$ term gets evaluated.
+     */
+    enum NonLinearity {
+        Global = 0, //! The squared norm of the whole wave is added to every diagonal element.
+        Local = 1   //! The squared amplitude \f$ |x_i|^2 \f$ at each position is added to its diagonal element.
+    };
+
     /**
      * @brief NonLinearHamiltonianSolver construct the hamiltonian matrix from the SimulationParamter and a PotentialFunction.
      * @param Parameter The Parameter with time step and resolution.
      * @param PotentialFunction The potential function which must be a function of the form:
      *                          \f$ f:[0,1]\rightarrow\mathbb{R} \f$
      * @param factor A factor for the influence of the \f$ |x(r,t)|^2 \f$ term.
+     * @param Mode The evaluation of the \f$ |x(r,t)|^2 \f$ term.
      */
     NonLinearHamiltonianSolver(SimulationParameter Parameter,
                          std::function<double (double)> PotentialFunction,
-                         const double Factor)
-        : parameter(Parameter), potentialFunction(PotentialFunction), factor(Factor) {
-        hamiltonian = TridiagonalMatrix<T>(parameter.atomCount);
+                         const double Factor,
+                         NonLinearity Mode = Global)
+        : NonLinearHamiltonianSolver(Parameter, HamiltonianSolver<T>::samplePotential(PotentialFunction, Parameter.atomCount), Factor, Mode) {
+        potentialFunction = PotentialFunction;
+    }
+
+    /**
+     * @brief NonLinearHamiltonianSolver construct the hamiltonian matrix from the SimulationParamter and a sampled potential.
+     *                                   This allows simulations on the same grid to share the sampling of the potential.
+     * @param Parameter The Parameter with time step and resolution.
+     * @param Potential The potential at the positions \f$ i / N \f$ of the atoms.
+     * @param factor A factor for the influence of the \f$ |x(r,t)|^2 \f$ term.
+     * @param Mode The evaluation of the \f$ |x(r,t)|^2 \f$ term.
+     */
+    NonLinearHamiltonianSolver(SimulationParameter Parameter,
+                         const std::vector<double>& Potential,
+                         const double Factor,
+                         NonLinearity Mode = Global)
+        : parameter(Parameter), factor(Factor), mode(Mode), imaginaryLambda(0), factorizedNorm(-1) {
+        assert(Potential.size() == parameter.atomCount);
+        hamiltonian = StencilHamiltonian<T>(parameter.atomCount, -1.0);
+        potential.resize(parameter.atomCount);
         for (unsigned int i = 0; i < parameter.atomCount; ++i) {
-            hamiltonian(TridiagonalMatrix<T>::Lower, i) = std::complex<double>(-1.0, 0);
-            hamiltonian(TridiagonalMatrix<T>::Diagonal, i) = std::complex<double>( 2.0 + 2 * potentialFunction(static_cast<double>(i) / parameter.atomCount) + factor, 0);
-            hamiltonian(TridiagonalMatrix<T>::Upper, i) = std::complex<double>(-1.0, 0);
+            potential[i] = 2.0 + 2 * Potential[i];
+            hamiltonian(i) = potential[i] + factor;
         }
-
-        left = TridiagonalMatrix<T>::identity(parameter.atomCount, std::complex<double>(1.0, 0)) +
-                hamiltonian * std::complex<double>(0, parameter.lambda);
-        right = TridiagonalMatrix<T>::identity(parameter.atomCount, std::complex<double>(1.0, 0)) -
-                hamiltonian * std::complex<double>(0, parameter.lambda);
     }
 
     /**
@@ -60,23 +95,61 @@ public:
      * @return The new wave in the next timestep of the simulation.
      */
     virtual Vector<T> solve(const Vector<T>& current) override {
-        /*double absV = 0;
-        for (unsigned int i = 0; i < parameter.atomCount; ++i) {
-            absV += std::abs(current(i));
-        }*/
+        Vector<T> next(current);
+        updateDiagonal(current);
+        propagator.factorizeAndPropagate(hamiltonian, parameter.lambda, next);
+        return next;
+    }
 
-        for (unsigned int i = 0; i < parameter.atomCount; ++i) {
-            double absV = current.dot(current).real();
-            hamiltonian(TridiagonalMatrix<T>::Lower, i) = std::complex<double>(-1.0, 0);
-            hamiltonian(TridiagonalMatrix<T>::Diagonal, i) = std::complex<double>( 2.0 + 2 * potentialFunction(static_cast<double>(i) / parameter.atomCount) + factor * absV, 0);
-            hamiltonian(TridiagonalMatrix<T>::Upper, i) = std::complex<double>(-1.0, 0);
+    /**
+     * @brief #step Propagate the wave function one timestep inplace without any allocation.
+     *              Large systems get partitioned over the threads of the workspace.
+     * @param state The current wave vector of the simulation, which gets replaced by the next timestep.
+     * @param workspace The preallocated buffers for the step.
+     */
+    virtual void step(Vector<T>& state, typename HamiltonianSolver<T>::Workspace& workspace) override {
+        if (imaginaryLambda != 0) {
+            imaginaryStep(state);
+        } else if (workspace.pool && PartitionedTridiagonalFactorization<T>::isSuitable(state.size(), workspace.pool->getThreadCount())) {
+            updateDiagonal(state);
+            {
+                ProfileScope scope(Profiler::SolverAssemble);
+                hamiltonian.toCrankNicolson(left, parameter.lambda, 1.0);
+                hamiltonian.toCrankNicolson(right, parameter.lambda, -1.0);
+            }
+            {
+                ProfileScope scope(Profiler::SolverFactorize);
+                partition.factorize(left, *workspace.pool);
+            }
+            ProfileScope scope(Profiler::SolverPropagate);
+            partition.propagate(right, state, *workspace.pool);
+        } else {
+            updateDiagonal(state);
+            ProfileScope scope(Profiler::SolverPropagate);
+            propagator.factorizeAndPropagate(hamiltonian, parameter.lambda, state);
         }
+    }
 
-        left = TridiagonalMatrix<T>::identity(parameter.atomCount, std::complex<double>(1.0, 0)) +
-                hamiltonian * std::complex<double>(0, parameter.lambda);
-        right = TridiagonalMatrix<T>::identity(parameter.atomCount, std::complex<double>(1.0, 0)) -
-                hamiltonian * std::complex<double>(0, parameter.lambda);
-        return getLeftMatrix().solve(getRightMatrix() * current);
+    /**
+     * @brief #setImaginaryTime Switch between real time and imaginary time steps.
+     *                          Imaginary time steps are always solved on a single thread.
+     * @param lambda The \f$ \lambda \f$ of the imaginary time step or zero to return to real time.
+     * @return True, the solver supports imaginary time.
+     */
+    virtual bool setImaginaryTime(double lambda) override {
+        imaginaryLambda = lambda;
+        factorizedNorm = -1;
+        return true;
+    }
+
+    /**
+     * @brief #applyHamiltonian Multiply a state with the hamiltonian of this state without building the matrix.
+     * @param state The state \f$ x \f$.
+     * @param result The vector to write \f$ H(x)x \f$ into.
+     */
+    virtual void applyHamiltonian(const Vector<T>& state, Vector<T>& result) override {
+        updateDiagonal(state);
+        hamiltonian.multiply(state, result);
     }
 
     /**
@@ -84,7 +157,7 @@ public:
      * @return The Hamilton matrix.
      */
     virtual TridiagonalMatrix<T> getHamiltonianMatrix() override {
-        return hamiltonian;
+        return hamiltonian.toMatrix();
     }
 
     /**
@@ -92,7 +165,9 @@ public:
      * @return The left assigned matrix.
      */
     virtual TridiagonalMatrix<T> getLeftMatrix() override {
-        return left;
+        TridiagonalMatrix<T> mat;
+        hamiltonian.toCrankNicolson(mat, parameter.lambda, 1.0);
+        return mat;
     }
 
     /**
@@ -100,14 +175,63 @@ public:
      * @return The right assigned matrix.
      */
     virtual TridiagonalMatrix<T> getRightMatrix() override {
-        return right;
+        TridiagonalMatrix<T> mat;
+        hamiltonian.toCrankNicolson(mat, parameter.lambda, -1.0);
+        return mat;
     }
 
 private:
-    TridiagonalMatrix<T> hamiltonian;
-    TridiagonalMatrix<T> left;
-    TridiagonalMatrix<T> right;
+    /**
+     * @brief #imaginaryStep Propagate the state one imaginary time step.
+     *                       The factorization of the left matrix is reused while the Global norm term stays the same.
+     * @param state The current state, which gets replaced by the next step.
+     */
+    void imaginaryStep(Vector<T>& state) {
+        if (mode == Global) {
+            const double norm = state.squaredNorm();
+            if (std::abs(norm - factorizedNorm) > 1e-12 * norm) {
+                updateDiagonal(state);
+                ProfileScope scope(Profiler::SolverFactorize);
+                propagator.factorize(hamiltonian, imaginaryLambda, true);
+                factorizedNorm = norm;
+            }
+            ProfileScope scope(Profiler::SolverPropagate);
+            propagator.propagate(hamiltonian, state);
+        } else {
+            updateDiagonal(state);
+            ProfileScope scope(Profiler::SolverPropagate);
+            propagator.factorizeAndPropagate(hamiltonian, imaginaryLambda, state, true);
+        }
+    }
+
+    /**
+     * @brief #updateDiagonal Rewrite the diagonal of the hamiltonian for the current wave function.
+     * @param current The current wave vector of the simulation.
+     */
+    void updateDiagonal(const Vector<T>& current) {
+        ProfileScope scope(Profiler::SolverPotential);
+        if (mode == Global) {
+            const double norm = factor * current.squaredNorm();
+            for (unsigned int i = 0; i < parameter.atomCount; ++i) {
+                hamiltonian(i) = potential[i] + norm;
+            }
+        } else {
+            for (unsigned int i = 0; i < parameter.atomCount; ++i) {
+                hamiltonian(i) = potential[i] + factor * std::norm(current[i]);
+            }
+        }
+    }
+
+    StencilHamiltonian<T> hamiltonian;
+    StencilPropagator<T> propagator;
+    TridiagonalMatrix<T> left;  //! Only built for the partitioned solve
+    TridiagonalMatrix<T> right; //! Only built for the partitioned solve
+    PartitionedTridiagonalFactorization<T> partition;
     SimulationParameter parameter;
     std::function<double (double)> potentialFunction;
+    std::vector<double> potential;
     double factor;
+    NonLinearity mode;
+    double imaginaryLambda; //! The \f$ \lambda \f$ of the imaginary time step, zero in real time
+    double factorizedNorm;  //! The squared norm of the Global term of the factorized left matrix
 };
@@ -1,10 +1,46 @@
 #include "observable.h"
 
+#include <cmath>
+
 Observable::Observable(CheckTime Time)
-    : time(Time) {
+    : time(Time), stride(1), start(0), stop(-1), interval(0), synchronous(false) {
+}
+
+Observable::~Observable() {
 }
 
-bool Observable::check(CheckTime currentTime) {
+bool Observable::check(CheckTime currentTime) const {
     return (time & currentTime) == currentTime;
 }
 
+bool Observable::check(CheckTime currentTime, int iteration, double dt) const {
+    if (!check(currentTime)) {
+        return false;
+    }
+    if (currentTime != Iteration) {
+        return true;
+    }
+    if (iteration < start || (stop >= 0 && iteration >= stop)) {
+        return false;
+    }
+    if (static_cast<unsigned int>(iteration - start) % stride != 0) {
+        return false;
+    }
+    if (interval > 0 && iteration > 0) {
+        return std::floor(iteration * dt / interval) != std::floor((iteration - 1) * dt / interval);
+    }
+    return true;
+}
+
+void Observable::setStride(unsigned int Stride) {
+    stride = Stride > 0 ? Stride : 1;
+}
+
+void Observable::setWindow(int Start, int Stop) {
+    start = Start;
+    stop = Stop;
+}
+
+void Observable::setTimeInterval(double Interval) {
+    interval = Interval;
+}
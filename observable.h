@@ -6,6 +6,8 @@ class Simulation;
  * @brief Oberservable base class to filter a property of the current simulation.
  *        If you want to implement a custom observable inherit from this class.
  *        This can be for example the current properbility of the wave or the potential
+ *        An observable at the Iteration time may be restricted to a window of iterations and to every
+ *        n-th iteration or to steps of the simulated time, the simulation skips it for all other iterations.
  */
 class Observable
 {
@@ -25,12 +27,60 @@ public:
      */
     Observable(CheckTime Time);
 
+    /**
+     * @brief ~Observable Virtual destructor for the derived observables.
+     */
+    virtual ~Observable();
+
     /**
      * @brief #check Return true if the observable should filter at the given time.
      * @param currentTime The current time in the simulation.
      * @return true if the observable should filter at the current simulation time, otherwise false.
      */
-    bool check(CheckTime currentTime);
+    bool check(CheckTime currentTime) const;
+
+    /**
+     * @brief #check Return true if the observable should filter at the given time and iteration.
+     * @param currentTime The current time in the simulation.
+     * @param iteration The current iteration of the simulation.
+     * @param dt The time step of the simulation.
+     * @return true if the observable should filter at the current iteration, otherwise false.
+     */
+    bool check(CheckTime currentTime, int iteration, double dt) const;
+
+    /**
+     * @brief #setStride Filter only every n-th iteration, counted from the start of the window.
+     * @param Stride The distance between two filtered iterations, one filters every iteration.
+     */
+    void setStride(unsigned int Stride);
+
+    /**
+     * @brief #setWindow Filter only the iterations in [start, stop).
+     * @param Start The first iteration to filter.
+     * @param Stop The first iteration which is not filtered anymore, a negative value filters until the end.
+     */
+    void setWindow(int Start, int Stop = -1);
+
+    /**
+     * @brief #setTimeInterval Filter only the iterations at which the simulated time \f$ n \cdot \Delta t \f$
+     *                         passes a multiple of the interval.
+     * @param Interval The simulated time between two filtered iterations, zero disables the trigger.
+     */
+    void setTimeInterval(double Interval);
+
+    /**
+     * @brief #setSynchronous Keep the observable in the simulation loop, even if the iteration observables run
+     *                        on background threads, see Simulation::setAsyncObservers. This is required for
+     *                        observables which query the solver, because the solver changes with every step.
+     * @param Synchronous True to filter in the simulation loop.
+     */
+    void setSynchronous(bool Synchronous) { synchronous = Synchronous; }
+
+    /**
+     * @brief #isSynchronous Return true if the observable always filters in the simulation loop.
+     * @return True if the observable must not run on a background thread.
+     */
+    bool isSynchronous() const { return synchronous; }
 
     /**
      * @brief #filter Filter a property from the current simulation step.
@@ -40,4 +90,9 @@ public:
 
 private:
     CheckTime time;
+    unsigned int stride;
+    int start;
+    int stop;
+    double interval;
+    bool synchronous;
 };
@@ -0,0 +1,126 @@
+#include "observablepipeline.h"
+
+#include <algorithm>
+
+#include "simulation.h"
+#include "profiler.h"
+
+ObservablePipeline::ObservablePipeline(const Simulation& simulation, Observable::CheckTime Time, unsigned int Threads, unsigned int Snapshots)
+    : time(Time), dt(simulation.parameter.dt), count(0), stopping(false) {
+    const unsigned int threadCount = std::max(Threads, 1u);
+    observables.resize(threadCount);
+    unsigned int next = 0;
+    for (auto& it : simulation.filter) {
+        if (it->check(time) && !it->isSynchronous()) {
+            observables[next++ % threadCount].push_back(it);
+        }
+    }
+
+    for (unsigned int i = 0; i < std::max(Snapshots, 1u); ++i) {
+        snapshots.push_back(std::unique_ptr<Simulation>(simulation.createSnapshot()));
+    }
+
+    consumed.resize(threadCount, 0);
+    for (unsigned int i = 0; i < threadCount; ++i) {
+        threads.push_back(std::thread(&ObservablePipeline::work, this, i));
+    }
+}
+
+ObservablePipeline::~ObservablePipeline() {
+    stop();
+}
+
+void ObservablePipeline::publish(const Simulation& simulation) {
+    if (!observed(simulation.currentIteration)) {
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    released.wait(lock, [this] { return count - oldest() < snapshots.size() || error; });
+    if (error) {
+        lock.unlock();
+        stop();
+        std::rethrow_exception(error);
+    }
+
+    // the slot is not used by any thread, so it can be written without the lock
+    Simulation& snapshot = *snapshots[count % snapshots.size()];
+    lock.unlock();
+    snapshot.atoms = simulation.atoms;
+    snapshot.currentIteration = simulation.currentIteration;
+
+    lock.lock();
+    ++count;
+    lock.unlock();
+    published.notify_all();
+}
+
+void ObservablePipeline::finish() {
+    stop();
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+void ObservablePipeline::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    published.notify_all();
+    for (auto& it : threads) {
+        if (it.joinable()) {
+            it.join();
+        }
+    }
+}
+
+bool ObservablePipeline::observed(int iteration) const {
+    for (auto& group : observables) {
+        for (auto& it : group) {
+            if (it->check(time, iteration, dt)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+unsigned long ObservablePipeline::oldest() const {
+    return *std::min_element(consumed.begin(), consumed.end());
+}
+
+void ObservablePipeline::work(unsigned int thread) {
+    while (true) {
+        unsigned long current;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            published.wait(lock, [this, thread] { return consumed[thread] < count || stopping; });
+            if (consumed[thread] == count || error) {
+                return;
+            }
+            current = consumed[thread];
+        }
+
+        try {
+            const Simulation& snapshot = *snapshots[current % snapshots.size()];
+            for (auto& it : observables[thread]) {
+                if (it->check(time, snapshot.currentIteration, dt)) {
+                    ProfileScope scope(typeid(*it), "observable.");
+                    it->filter(snapshot);
+                }
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!error) {
+                error = std::current_exception();
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ++consumed[thread];
+        }
+        released.notify_all();
+    }
+}
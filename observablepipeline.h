@@ -0,0 +1,78 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <exception>
+#include <condition_variable>
+
+#include "observable.h"
+
+class Simulation;
+
+/**
+ * @brief The ObservablePipeline class runs the observables of a simulation on background threads.
+ *        The simulation publishes a snapshot of its state after every step into a ring of preallocated
+ *        snapshots and continues with the next step, while the observables filter the snapshots.
+ *        Every observable is owned by one thread, so it sees the snapshots in order and never gets called
+ *        concurrently. If all snapshots are still in use, #publish blocks until the slowest thread is done
+ *        with the oldest one, which bounds the memory and the lag of the observables. Iterations which none
+ *        of the observables filter do not get copied.
+ *        The snapshots only hold the state of the simulation, so synchronous observables, which query the solver,
+ *        stay in the simulation loop, see Observable::setSynchronous.
+ */
+class ObservablePipeline
+{
+public:
+    /**
+     * @brief ObservablePipeline Allocate the snapshots and start the threads.
+     * @param simulation The simulation to observe.
+     * @param time The time at which the observables of the simulation get moved into the pipeline,
+     *             except for the synchronous ones.
+     * @param Threads The number of background threads.
+     * @param Snapshots The number of snapshots in the ring.
+     */
+    ObservablePipeline(const Simulation& simulation, Observable::CheckTime time, unsigned int Threads, unsigned int Snapshots);
+
+    /**
+     * @brief ~ObservablePipeline Stop the threads, pending snapshots get filtered first.
+     */
+    ~ObservablePipeline();
+
+    ObservablePipeline(const ObservablePipeline&) = delete;
+    ObservablePipeline& operator = (const ObservablePipeline&) = delete;
+
+    /**
+     * @brief #publish Copy the state of the simulation into the next free snapshot and hand it to the threads.
+     *                 Blocks while all snapshots are in use. Does nothing if no observable filters the current iteration.
+     * @param simulation The simulation with the current state.
+     * @throw The first exception of an observable, which stops the pipeline.
+     */
+    void publish(const Simulation& simulation);
+
+    /**
+     * @brief #finish Wait until all published snapshots are filtered and stop the threads.
+     * @throw The first exception of an observable.
+     */
+    void finish();
+
+private:
+    void work(unsigned int thread);
+    bool observed(int iteration) const;
+    unsigned long oldest() const;
+    void stop();
+
+    std::vector<std::unique_ptr<Simulation>> snapshots;
+    std::vector<std::vector<std::shared_ptr<Observable>>> observables;
+    std::vector<std::thread> threads;
+    std::vector<unsigned long> consumed;
+    std::mutex mutex;
+    std::condition_variable published;
+    std::condition_variable released;
+    std::exception_ptr error;
+    Observable::CheckTime time;
+    double dt;
+    unsigned long count;
+    bool stopping;
+};
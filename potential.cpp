@@ -0,0 +1,124 @@
+#include "potential.h"
+
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <stdexcept>
+
+void Potential::sample(double* values, unsigned int atomCount, double t) const {
+    for (unsigned int i = 0; i < atomCount; ++i) {
+        values[i] = (*this)(static_cast<double>(i) / atomCount, t);
+    }
+}
+
+std::vector<double> Potential::sample(unsigned int atomCount, double t) const {
+    std::vector<double> values(atomCount);
+    sample(values.data(), atomCount, t);
+    return values;
+}
+
+double PeriodicPotential::operator () (double x, double /*t*/) const {
+    return amplitude * std::cos(2 * std::acos(-1.0) * x / period + phase);
+}
+
+TabulatedPotential::TabulatedPotential(const std::string& filename, Interpolation Mode)
+    : mode(Mode) {
+    std::ifstream file(filename.c_str());
+    if (!file) {
+        throw std::runtime_error("could not open potential " + filename);
+    }
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream fields(line);
+        double x, y;
+        if (line.empty() || line[0] == '#' || !(fields >> x)) {
+            continue;
+        }
+        if (!(fields >> y)) {
+            throw std::runtime_error("missing value in potential " + filename + ": " + line);
+        }
+        xs.push_back(x);
+        ys.push_back(y);
+    }
+    initialize();
+}
+
+TabulatedPotential::TabulatedPotential(const std::vector<double>& X, const std::vector<double>& Y, Interpolation Mode)
+    : xs(X), ys(Y), mode(Mode) {
+    if (xs.size() != ys.size()) {
+        throw std::runtime_error("the tabulated potential needs a value for every position");
+    }
+    initialize();
+}
+
+void TabulatedPotential::initialize() {
+    if (xs.size() < 2) {
+        throw std::runtime_error("the tabulated potential needs at least two points");
+    }
+    for (size_t i = 1; i < xs.size(); ++i) {
+        if (!(xs[i] > xs[i - 1])) {
+            throw std::runtime_error("the positions of the tabulated potential must increase");
+        }
+    }
+    if (mode != Cubic) {
+        return;
+    }
+
+    // natural spline, solve the tridiagonal system for the second derivatives with the Thomas algorithm
+    const size_t n = xs.size();
+    curvature.assign(n, 0.0);
+    std::vector<double> upper(n, 0.0);
+    for (size_t i = 1; i + 1 < n; ++i) {
+        const double h0 = xs[i] - xs[i - 1];
+        const double h1 = xs[i + 1] - xs[i];
+        const double rhs = 6 * ((ys[i + 1] - ys[i]) / h1 - (ys[i] - ys[i - 1]) / h0);
+        const double pivot = 2 * (h0 + h1) - h0 * upper[i - 1];
+        upper[i] = h1 / pivot;
+        curvature[i] = (rhs - h0 * curvature[i - 1]) / pivot;
+    }
+    for (size_t i = n - 2; i > 0; --i) {
+        curvature[i] -= upper[i] * curvature[i + 1];
+    }
+}
+
+double TabulatedPotential::interpolate(unsigned int segment, double x) const {
+    if (x <= xs.front()) {
+        return ys.front();
+    }
+    if (x >= xs.back()) {
+        return ys.back();
+    }
+    const double h = xs[segment + 1] - xs[segment];
+    const double a = (xs[segment + 1] - x) / h;
+    const double b = 1 - a;
+    double value = a * ys[segment] + b * ys[segment + 1];
+    if (mode == Cubic) {
+        value += ((a * a * a - a) * curvature[segment] + (b * b * b - b) * curvature[segment + 1]) * h * h / 6;
+    }
+    return value;
+}
+
+double TabulatedPotential::operator () (double x, double /*t*/) const {
+    const size_t upper = std::upper_bound(xs.begin(), xs.end(), x) - xs.begin();
+    const size_t segment = std::min(std::max<size_t>(upper, 1), xs.size() - 1) - 1;
+    return interpolate(static_cast<unsigned int>(segment), x);
+}
+
+void TabulatedPotential::sample(double* values, unsigned int atomCount, double /*t*/) const {
+    unsigned int segment = 0;
+    for (unsigned int i = 0; i < atomCount; ++i) {
+        const double x = static_cast<double>(i) / atomCount;
+        while (segment + 2 < xs.size() && xs[segment + 1] <= x) {
+            ++segment;
+        }
+        values[i] = interpolate(segment, x);
+    }
+}
+
+void ExpressionPotential::sample(double* values, unsigned int atomCount, double t) const {
+    for (unsigned int i = 0; i < atomCount; ++i) {
+        values[i] = static_cast<double>(i) / atomCount;
+    }
+    expression.evaluate(values, t, values, atomCount, workspace);
+}
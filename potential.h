@@ -0,0 +1,235 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "expression.h"
+
+/**
+ * @brief The Potential class is the base of the native potentials \f$ V(x, t) \f$ on the positions
+ *        \f$ x \in [0, 1] \f$, which get sampled without calling back into python.
+ */
+class Potential
+{
+public:
+    virtual ~Potential() {}
+
+    /**
+     * @brief #operator () Evaluate the potential at a single position.
+     * @param x The position in [0, 1].
+     * @param t The simulation time.
+     * @return The value of the potential.
+     */
+    virtual double operator () (double x, double t = 0) const = 0;
+
+    /**
+     * @brief #sample Sample the potential at the positions \f$ i / N \f$ of the atoms.
+     * @param values The array to write the atomCount values into.
+     * @param atomCount The atom count \f$ N \f$ in the simulation.
+     * @param t The simulation time.
+     */
+    virtual void sample(double* values, unsigned int atomCount, double t = 0) const;
+
+    /**
+     * @brief #sample Sample the potential at the positions \f$ i / N \f$ of the atoms.
+     * @param atomCount The atom count \f$ N \f$ in the simulation.
+     * @param t The simulation time.
+     * @return The values for every atom.
+     */
+    std::vector<double> sample(unsigned int atomCount, double t = 0) const;
+
+    /**
+     * @brief #isTimeDependent Return if the potential changes with the simulation time.
+     * @return True if the potential must be sampled again for every time.
+     */
+    virtual bool isTimeDependent() const { return false; }
+};
+
+/**
+ * @brief The HarmonicPotential class The potential \f$ V(x) = \frac{1}{2}\omega^2 (x - x_0)^2 \f$.
+ */
+class HarmonicPotential : public Potential
+{
+public:
+    /**
+     * @brief HarmonicPotential Construct a harmonic potential.
+     * @param Omega The angular frequency \f$ \omega \f$.
+     * @param Center The position of the minimum \f$ x_0 \f$.
+     */
+    HarmonicPotential(double Omega, double Center = 0.5) : omega(Omega), center(Center) {
+    }
+
+    virtual double operator () (double x, double /*t*/ = 0) const {
+        return 0.5 * omega * omega * (x - center) * (x - center);
+    }
+
+private:
+    double omega;
+    double center;
+};
+
+/**
+ * @brief The BoxPotential class A potential well, which is zero within [left, right] and height outside.
+ */
+class BoxPotential : public Potential
+{
+public:
+    /**
+     * @brief BoxPotential Construct a potential well.
+     * @param Left The left wall of the box.
+     * @param Right The right wall of the box.
+     * @param Height The potential outside the box.
+     */
+    BoxPotential(double Left, double Right, double Height) : left(Left), right(Right), height(Height) {
+    }
+
+    virtual double operator () (double x, double /*t*/ = 0) const {
+        return (x < left || x > right) ? height : 0.0;
+    }
+
+private:
+    double left;
+    double right;
+    double height;
+};
+
+/**
+ * @brief The StepPotential class A potential, which is zero left of the step and height from the step on.
+ */
+class StepPotential : public Potential
+{
+public:
+    /**
+     * @brief StepPotential Construct a potential step.
+     * @param Position The position of the step.
+     * @param Height The potential right of the step.
+     */
+    StepPotential(double Position, double Height) : position(Position), height(Height) {
+    }
+
+    virtual double operator () (double x, double /*t*/ = 0) const {
+        return x < position ? 0.0 : height;
+    }
+
+private:
+    double position;
+    double height;
+};
+
+/**
+ * @brief The PeriodicPotential class The lattice potential \f$ V(x) = A \cos(2\pi x / a + \varphi) \f$.
+ */
+class PeriodicPotential : public Potential
+{
+public:
+    /**
+     * @brief PeriodicPotential Construct a periodic potential.
+     * @param Amplitude The amplitude \f$ A \f$.
+     * @param Period The lattice constant \f$ a \f$.
+     * @param Phase The phase \f$ \varphi \f$.
+     */
+    PeriodicPotential(double Amplitude, double Period, double Phase = 0) : amplitude(Amplitude), period(Period), phase(Phase) {
+    }
+
+    virtual double operator () (double x, double t = 0) const;
+
+private:
+    double amplitude;
+    double period;
+    double phase;
+};
+
+/**
+ * @brief The TabulatedPotential class A potential which interpolates the values of a file.
+ *        The file holds a line "x value" per point, which is the format written by the PotentialObservable.
+ *        Empty lines and lines starting with # are skipped. Outside the table the first or last value is used.
+ */
+class TabulatedPotential : public Potential
+{
+public:
+    /**
+     * @brief The Interpolation enum selects the interpolation between the points of the table.
+     */
+    enum Interpolation {
+        Linear, //! Piecewise linear interpolation
+        Cubic   //! Natural cubic spline
+    };
+
+    /**
+     * @brief TabulatedPotential Load a potential from a file.
+     * @param filename The file to load the points from.
+     * @param Mode The interpolation between the points.
+     * @throw std::runtime_error if the file can not be read, has less than two points or the positions do not increase.
+     */
+    TabulatedPotential(const std::string& filename, Interpolation Mode = Linear);
+
+    /**
+     * @brief TabulatedPotential Construct a potential from points.
+     * @param X The increasing positions of the points.
+     * @param Y The values at the positions.
+     * @param Mode The interpolation between the points.
+     * @throw std::runtime_error if there are less than two points or the positions do not increase.
+     */
+    TabulatedPotential(const std::vector<double>& X, const std::vector<double>& Y, Interpolation Mode = Linear);
+
+    virtual double operator () (double x, double t = 0) const;
+
+    using Potential::sample;
+
+    /**
+     * @brief #sample Sample the potential, the increasing positions of the atoms walk through the table once.
+     */
+    virtual void sample(double* values, unsigned int atomCount, double t = 0) const;
+
+private:
+    void initialize();
+    double interpolate(unsigned int segment, double x) const;
+
+    std::vector<double> xs;
+    std::vector<double> ys;
+    std::vector<double> curvature; //! The second derivatives of the cubic spline
+    Interpolation mode;
+};
+
+/**
+ * @brief The ExpressionPotential class A potential given by a formula, see Expression.
+ */
+class ExpressionPotential : public Potential
+{
+public:
+    /**
+     * @brief ExpressionPotential Compile a formula.
+     * @param Formula The formula of the potential.
+     * @throw std::invalid_argument if the formula is no valid expression.
+     */
+    ExpressionPotential(const std::string& Formula) : expression(Formula) {
+    }
+
+    virtual double operator () (double x, double t = 0) const {
+        return expression(x, t);
+    }
+
+    using Potential::sample;
+
+    /**
+     * @brief #sample Sample the formula at the positions \f$ i / N \f$ of the atoms.
+     *                The stack of the evaluation is kept, so sampling a time dependent formula every step does not
+     *                allocate. Therefore a potential must not be sampled by several threads at the same time.
+     * @param values The array to write the atomCount values into.
+     * @param atomCount The atom count \f$ N \f$ in the simulation.
+     * @param t The simulation time.
+     */
+    virtual void sample(double* values, unsigned int atomCount, double t = 0) const;
+
+    virtual bool isTimeDependent() const { return expression.dependsOnTime(); }
+
+    /**
+     * @brief #getFormula Return the formula of the potential.
+     * @return The formula string.
+     */
+    const std::string& getFormula() const { return expression.getFormula(); }
+
+private:
+    Expression expression;
+    mutable Expression::Workspace workspace;
+};
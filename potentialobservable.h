@@ -1,7 +1,10 @@
 #pragma once
 
+#include <assert.h>
 #include <memory>
 #include <ostream>
+#include <vector>
+#include <functional>
 
 #include "observable.h"
 #include "simulation.h"
@@ -22,15 +25,29 @@ public:
          stream.reset(&output, [] (std::ostream* s) {});
     }
 
+    /**
+     * @brief PotentialObservable Constructs a new observable which writes an already sampled potential at startup.
+     *                            The samples of a solver can be reused, so the potential does not get evaluated twice.
+     * @param output The stream to write the potential into.
+     * @param Potential The values \f$ V(i / N) \f$ for every atom \f$ i \f$.
+     * @require The potential must have one value per atom of the simulation.
+     */
+    PotentialObservable(std::ostream& output, const std::vector<double>& Potential)
+        : Observable(Observable::Startup), samples(Potential) {
+         stream.reset(&output, [] (std::ostream* s) {});
+    }
+
     /**
      * @brief #filter Filter the potential.
      * @param sim The current simulation step.
      */
     virtual void filter(const Simulation& sim) {
-        for (unsigned int i = 0; i < sim.getAtoms().size(); ++i) {
-            (*stream.get()) << static_cast<double>(i) / sim.getAtoms().size()
+        const unsigned int size = sim.getAtoms().size();
+        assert(samples.empty() || samples.size() == size);
+        for (unsigned int i = 0; i < size; ++i) {
+            (*stream.get()) << static_cast<double>(i) / size
                             << " "
-                            << func(static_cast<double>(i) / sim.getAtoms().size())
+                            << (samples.empty() ? func(static_cast<double>(i) / size) : samples[i])
                             << "\n";
         }
         (*stream.get()) << "\n";
@@ -39,4 +56,5 @@ public:
 private:
     std::shared_ptr<std::ostream> stream;
     std::function<double (double)> func;
+    std::vector<double> samples;
 };
@@ -0,0 +1,255 @@
+#include "profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <utility>
+
+#ifdef __GNUG__
+#include <cxxabi.h>
+#endif
+
+namespace {
+
+/**
+ * @brief #demangle Return the readable name of a type.
+ * @param type The type.
+ * @return The demangled name, or the raw name if the compiler offers no demangling.
+ */
+std::string demangle(const std::type_info& type) {
+#ifdef __GNUG__
+    int status = 0;
+    char* name = abi::__cxa_demangle(type.name(), nullptr, nullptr, &status);
+    if (status == 0 && name) {
+        std::string result(name);
+        std::free(name);
+        return result;
+    }
+#endif
+    return type.name();
+}
+
+/**
+ * @brief #writeString Write a string as a quoted and escaped JSON string.
+ * @param output The stream to write into.
+ * @param value The string.
+ */
+void writeString(std::ostream& output, const std::string& value) {
+    output << '"';
+    for (char c : value) {
+        if (c == '"' || c == '\\') {
+            output << '\\' << c;
+        } else if (static_cast<unsigned char>(c) >= 0x20) {
+            output << c;
+        }
+    }
+    output << '"';
+}
+
+}
+
+std::atomic<bool> Profiler::enabled(false);
+
+Profiler::Profiler()
+    : stages(new Stage[MaxStages]), stageCount(0), steps(0), stepTime(0), droppedEvents(0),
+      startTime(now()), tracing(false) {
+    static const char* const names[BuiltinCount] = {
+        "simulation.run", "simulation.loop", "solver.step", "solver.potential", "solver.assemble",
+        "solver.factorize", "solver.propagate", "simulation.boundary", "simulation.publish", "python.write", "trajectory.write",
+        "simulation.relax"
+    };
+    for (unsigned int i = 0; i < BuiltinCount; ++i) {
+        stages[i].name = names[i];
+    }
+    stageCount.store(BuiltinCount);
+    stages[MaxStages - 1].name = "other";
+    reset();
+}
+
+Profiler& Profiler::get() {
+    static Profiler profiler;
+    return profiler;
+}
+
+uint64_t Profiler::now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Profiler::enable(const std::string& ReportFile, const std::string& TraceFile) {
+    std::lock_guard<std::mutex> lock(mutex);
+    reportFile = ReportFile;
+    traceFile = TraceFile;
+    tracing = !TraceFile.empty();
+    enabled.store(true);
+}
+
+unsigned int Profiler::stage(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex);
+    const unsigned int count = stageCount.load();
+    for (unsigned int i = 0; i < count; ++i) {
+        if (stages[i].name == name) {
+            return i;
+        }
+    }
+    if (count == MaxStages - 1) {
+        return MaxStages - 1;
+    }
+    stages[count].name = name;
+    stageCount.store(count + 1);
+    return count;
+}
+
+unsigned int Profiler::stage(const std::type_info& type, const char* prefix) {
+    // the observables get looked up for every call, so the demangled names are cached
+    static std::map<std::pair<const std::type_info*, const char*>, unsigned int> cache;
+    const auto key = std::make_pair(&type, prefix);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = cache.find(key);
+        if (it != cache.end()) {
+            return it->second;
+        }
+    }
+    const unsigned int index = stage(prefix + demangle(type));
+    std::lock_guard<std::mutex> lock(mutex);
+    cache[key] = index;
+    return index;
+}
+
+void Profiler::record(unsigned int stage, uint64_t start, uint64_t stop, uint64_t bytes) {
+    Stage& s = stages[std::min(stage, MaxStages - 1)];
+    s.time.fetch_add(stop - start, std::memory_order_relaxed);
+    s.calls.fetch_add(1, std::memory_order_relaxed);
+    if (bytes > 0) {
+        s.bytes.fetch_add(bytes, std::memory_order_relaxed);
+    }
+    if (tracing) {
+        const Event event = { stage, threadIndex(), start, stop - start, bytes };
+        std::lock_guard<std::mutex> lock(mutex);
+        if (events.size() < MaxEvents) {
+            events.push_back(event);
+        } else {
+            ++droppedEvents;
+        }
+    }
+}
+
+void Profiler::addSteps(uint64_t count, uint64_t time) {
+    steps.fetch_add(count, std::memory_order_relaxed);
+    stepTime.fetch_add(time, std::memory_order_relaxed);
+}
+
+void Profiler::reset() {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (unsigned int i = 0; i < MaxStages; ++i) {
+        stages[i].time.store(0);
+        stages[i].calls.store(0);
+        stages[i].bytes.store(0);
+    }
+    steps.store(0);
+    stepTime.store(0);
+    droppedEvents.store(0);
+    events.clear();
+    startTime = now();
+}
+
+void Profiler::writeReport(std::ostream& output, const std::string& label) const {
+    const double wallTime = (now() - startTime) * 1e-9;
+    const double loopTime = stepTime.load() * 1e-9;
+
+    std::vector<unsigned int> order;
+    uint64_t totalBytes = 0;
+    for (unsigned int i = 0; i < MaxStages; ++i) {
+        if (stages[i].calls.load() > 0) {
+            order.push_back(i);
+            totalBytes += stages[i].bytes.load();
+        }
+    }
+    std::sort(order.begin(), order.end(), [this](unsigned int a, unsigned int b) {
+        return stages[a].time.load() > stages[b].time.load();
+    });
+
+    output << "{\n  \"simulation\": ";
+    writeString(output, label);
+    output << ",\n  \"wallTime\": " << wallTime
+           << ",\n  \"steps\": " << steps.load()
+           << ",\n  \"stepTime\": " << loopTime
+           << ",\n  \"stepsPerSecond\": " << (loopTime > 0 ? steps.load() / loopTime : 0.0)
+           << ",\n  \"bytesWritten\": " << totalBytes
+           << ",\n  \"stages\": [";
+    for (size_t i = 0; i < order.size(); ++i) {
+        const Stage& s = stages[order[i]];
+        const double time = s.time.load() * 1e-9;
+        output << (i == 0 ? "\n" : ",\n") << "    {\"name\": ";
+        writeString(output, s.name);
+        output << ", \"calls\": " << s.calls.load()
+               << ", \"time\": " << time
+               << ", \"meanTime\": " << time / s.calls.load()
+               << ", \"share\": " << (wallTime > 0 ? time / wallTime : 0.0)
+               << ", \"bytes\": " << s.bytes.load() << "}";
+    }
+    output << "\n  ]";
+    if (tracing) {
+        output << ",\n  \"droppedTraceEvents\": " << droppedEvents.load();
+    }
+    output << "\n}\n";
+}
+
+void Profiler::writeTrace(std::ostream& output) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    output << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+    for (size_t i = 0; i < events.size(); ++i) {
+        const Event& e = events[i];
+        output << (i == 0 ? "\n" : ",\n") << "{\"name\": ";
+        writeString(output, stages[std::min(e.stage, MaxStages - 1)].name);
+        output << ", \"ph\": \"X\", \"pid\": 0, \"tid\": " << e.thread
+               << ", \"ts\": " << (e.start - startTime) * 1e-3
+               << ", \"dur\": " << e.duration * 1e-3;
+        if (e.bytes > 0) {
+            output << ", \"args\": {\"bytes\": " << e.bytes << "}";
+        }
+        output << "}";
+    }
+    output << "\n]}\n";
+}
+
+void Profiler::save(const std::string& label, unsigned int index, unsigned int count) const {
+    if (!reportFile.empty()) {
+        std::ofstream output(indexedFilename(reportFile, index, count).c_str());
+        if (output) {
+            writeReport(output, label);
+        } else {
+            std::cerr << "could not write the profile " << reportFile << std::endl;
+        }
+    }
+    if (tracing) {
+        std::ofstream output(indexedFilename(traceFile, index, count).c_str());
+        if (output) {
+            writeTrace(output);
+        } else {
+            std::cerr << "could not write the trace " << traceFile << std::endl;
+        }
+    }
+}
+
+unsigned int Profiler::threadIndex() {
+    static std::atomic<unsigned int> next(0);
+    thread_local unsigned int index = next++;
+    return index;
+}
+
+std::string Profiler::indexedFilename(const std::string& filename, unsigned int index, unsigned int count) {
+    if (count <= 1) {
+        return filename;
+    }
+    const size_t dot = filename.find_last_of('.');
+    const size_t slash = filename.find_last_of('/');
+    const std::string suffix = "." + std::to_string(index);
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+        return filename + suffix;
+    }
+    return filename.substr(0, dot) + suffix + filename.substr(dot);
+}
@@ -0,0 +1,218 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+/**
+ * @brief The Profiler class collects the cumulative time, the call count and the written bytes of the stages
+ *        of a simulation, e.g. the sampling of the potential, the factorization, the substitution or an observable.
+ *        A stage gets registered once by its name and measured with a ProfileScope. The profiler is disabled by
+ *        default, then a scope only reads one flag. The times of nested stages are inclusive, e.g. the time of an
+ *        observable contains the time its python output spends in "python.write".
+ *        With a trace file every measured scope is also kept as an event of the Chrome trace format,
+ *        which can be opened with chrome://tracing or Perfetto.
+ */
+class Profiler
+{
+public:
+    /**
+     * @brief The Builtin enum holds the stages which get registered with the profiler, their index is the enum value.
+     */
+    enum Builtin {
+        SimulationRun,   //! The whole run of a simulation with its observables
+        SimulationLoop,  //! The iterations of a run without the startup and cooldown observables
+        SolverStep,      //! A step of the solver
+        SolverPotential, //! Sampling of a time dependent potential or evaluation of the state dependent terms
+        SolverAssemble,  //! Writing the diagonals of the hamiltonian and the Crank Nicolson matrices
+        SolverFactorize, //! The factorization of the left matrix
+        SolverPropagate, //! The product with the right matrix and the substitution, fused by the StencilPropagator
+        Boundary,        //! Resetting the boundary atoms after a step
+        Publish,         //! Copying the state for the asynchronous observables
+        PythonWrite,     //! Writing output through a python object
+        TrajectoryWrite, //! Writing frames of a binary trajectory
+        SimulationRelax, //! The imaginary time propagation before a run, see Simulation::relax
+        BuiltinCount
+    };
+
+    /**
+     * @brief #get Return the profiler of the process.
+     * @return The profiler.
+     */
+    static Profiler& get();
+
+    /**
+     * @brief #isEnabled Return if the stages get measured.
+     * @return True if the profiler is enabled.
+     */
+    static bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief #now Return the time of a monotonic clock.
+     * @return The time in nanoseconds.
+     */
+    static uint64_t now();
+
+    /**
+     * @brief #enable Enable the profiler, the reports get written by #save.
+     * @param ReportFile The file to write the JSON summary into, empty for no summary.
+     * @param TraceFile The file to write the Chrome trace into, empty for no trace.
+     */
+    void enable(const std::string& ReportFile, const std::string& TraceFile = "");
+
+    /**
+     * @brief #stage Return the index of the stage with the given name and register it on the first call.
+     * @param name The name of the stage.
+     * @return The index of the stage.
+     */
+    unsigned int stage(const std::string& name);
+
+    /**
+     * @brief #stage Return the index of the stage for a type, e.g. of an observable.
+     *               The name is the demangled type name with the given prefix.
+     * @param type The type of the measured object.
+     * @param prefix The prefix of the name.
+     * @return The index of the stage.
+     */
+    unsigned int stage(const std::type_info& type, const char* prefix);
+
+    /**
+     * @brief #record Add a measured call to a stage.
+     * @param stage The index of the stage.
+     * @param start The time the call started.
+     * @param stop The time the call returned.
+     * @param bytes The bytes written by the call.
+     */
+    void record(unsigned int stage, uint64_t start, uint64_t stop, uint64_t bytes = 0);
+
+    /**
+     * @brief #addSteps Count simulation steps for the steps per second of the report.
+     * @param steps The count of steps.
+     * @param time The time the steps took in nanoseconds.
+     */
+    void addSteps(uint64_t steps, uint64_t time);
+
+    /**
+     * @brief #reset Clear all measurements, the registered stages stay valid.
+     */
+    void reset();
+
+    /**
+     * @brief #writeReport Write the JSON summary of all stages.
+     * @param output The stream to write into.
+     * @param label The name of the profiled simulation.
+     */
+    void writeReport(std::ostream& output, const std::string& label) const;
+
+    /**
+     * @brief #writeTrace Write the recorded events in the Chrome trace format.
+     * @param output The stream to write into.
+     */
+    void writeTrace(std::ostream& output) const;
+
+    /**
+     * @brief #save Write the summary and the trace into the files given to #enable.
+     *              If a setting file holds several simulations the index gets inserted before the file extension.
+     * @param label The name of the profiled simulation.
+     * @param index The index of the simulation.
+     * @param count The count of simulations which get profiled.
+     */
+    void save(const std::string& label, unsigned int index = 0, unsigned int count = 1) const;
+
+private:
+    /**
+     * @brief The Stage struct holds the counters of a stage, they are updated by all threads without a lock.
+     */
+    struct Stage {
+        std::string name;
+        std::atomic<uint64_t> time;
+        std::atomic<uint64_t> calls;
+        std::atomic<uint64_t> bytes;
+    };
+
+    /**
+     * @brief The Event struct is a single measured call for the trace.
+     */
+    struct Event {
+        unsigned int stage;
+        unsigned int thread;
+        uint64_t start;
+        uint64_t duration;
+        uint64_t bytes;
+    };
+
+    static const unsigned int MaxStages = 256;        //! The last stage collects all stages beyond
+    static const size_t MaxEvents = 4 * 1024 * 1024; //! Later events get only counted
+
+    Profiler();
+    static unsigned int threadIndex();
+    static std::string indexedFilename(const std::string& filename, unsigned int index, unsigned int count);
+
+    static std::atomic<bool> enabled;
+
+    std::unique_ptr<Stage[]> stages;
+    std::atomic<unsigned int> stageCount;
+    std::atomic<uint64_t> steps;
+    std::atomic<uint64_t> stepTime;
+    std::atomic<uint64_t> droppedEvents;
+    uint64_t startTime;
+    bool tracing;
+    std::string reportFile;
+    std::string traceFile;
+    std::vector<Event> events;
+    mutable std::mutex mutex; //! Guards the registration of stages and the events
+};
+
+/**
+ * @brief The ProfileScope class measures the time from its construction to its destruction as a call of a stage.
+ *        If the profiler is disabled it does not read the clock.
+ */
+class ProfileScope
+{
+public:
+    /**
+     * @brief ProfileScope Start the measurement of a registered stage.
+     * @param Stage The index of the stage, a Profiler::Builtin or the result of Profiler::stage.
+     */
+    explicit ProfileScope(unsigned int Stage)
+        : stage(Stage), bytes(0), start(Profiler::isEnabled() ? Profiler::now() : 0) {
+    }
+
+    /**
+     * @brief ProfileScope Start the measurement of the stage of a type, which gets only looked up if the profiler is enabled.
+     * @param type The type of the measured object.
+     * @param prefix The prefix of the name of the stage.
+     */
+    ProfileScope(const std::type_info& type, const char* prefix)
+        : stage(0), bytes(0), start(0) {
+        if (Profiler::isEnabled()) {
+            stage = Profiler::get().stage(type, prefix);
+            start = Profiler::now();
+        }
+    }
+
+    ~ProfileScope() {
+        if (start != 0) {
+            Profiler::get().record(stage, start, Profiler::now(), bytes);
+        }
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator = (const ProfileScope&) = delete;
+
+    /**
+     * @brief #addBytes Count bytes which were written within the scope.
+     * @param count The count of bytes.
+     */
+    void addBytes(uint64_t count) { bytes += count; }
+
+private:
+    unsigned int stage;
+    uint64_t bytes;
+    uint64_t start;
+};
@@ -0,0 +1 @@
+#include "projectionobservable.h"
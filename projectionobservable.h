@@ -0,0 +1,75 @@
+#pragma once
+
+#include <algorithm>
+#include <complex>
+#include <limits>
+#include <memory>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+#include "observable.h"
+#include "simulation.h"
+#include "eigenbasis.h"
+#include "threadpool.h"
+
+/**
+ * @brief The ProjectionObservable class writes the populations \f$ |\langle\phi_n|\psi(t)\rangle|^2 \f$ of selected eigenstates
+ *        of the hamiltonian as a line "iteration p_0 p_1 ..." per filtered iteration. The eigenstates get computed once from
+ *        the hamiltonian of the first filtered iteration, see Eigenbasis, and are selected like the eigenvalues of the
+ *        EnergyEigenvalueObservable, so both observables use the same indices.
+ */
+class ProjectionObservable : public Observable
+{
+public:
+    /**
+     * @brief ProjectionObservable Construct a new observable for the populations of eigenstates.
+     * @param output The stream to write the data into.
+     * @param Lowest The count of the lowest eigenstates in the window, zero selects all of them.
+     * @param Lower The lower end of the energy window.
+     * @param Upper The upper end of the energy window, the eigenstates with eigenvalues in [Lower, Upper) get selected.
+     * @param Threads The count of threads to distribute the projection over, zero uses all cores.
+     */
+    ProjectionObservable(std::ostream& output,
+                         unsigned int Lowest = 10,
+                         double Lower = -std::numeric_limits<double>::infinity(),
+                         double Upper = std::numeric_limits<double>::infinity(),
+                         unsigned int Threads = 0)
+        : Observable(Observable::Iteration), lowest(Lowest), lower(Lower), upper(Upper),
+          threads(Threads > 0 ? Threads : std::max(1u, std::thread::hardware_concurrency())) {
+        stream.reset(&output, [] (std::ostream* s) {});
+        setSynchronous(true);
+    }
+
+    /**
+     * @brief #filter Project the current state onto the eigenstates.
+     * @param sim The current simulation step.
+     */
+    virtual void filter(const Simulation& sim) {
+        if (!pool) {
+            pool.reset(new ThreadPool(threads));
+        }
+        if (!basis) {
+            basis.reset(new Eigenbasis(sim.getSolver()->getHamiltonianMatrix(), lowest, lower, upper, pool.get()));
+            overlaps.resize(basis->getCount());
+        }
+        basis->project(sim.getAtoms(), overlaps.data(), pool.get());
+
+        std::ostream& out = *stream.get();
+        out << sim.getIteration();
+        for (const std::complex<double>& overlap : overlaps) {
+            out << " " << std::norm(overlap);
+        }
+        out << "\n";
+    }
+
+private:
+    std::shared_ptr<std::ostream> stream;
+    std::unique_ptr<ThreadPool> pool;
+    std::unique_ptr<Eigenbasis> basis;
+    std::vector<std::complex<double>> overlaps;
+    unsigned int lowest;
+    double lower;
+    double upper;
+    unsigned int threads;
+};
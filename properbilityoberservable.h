@@ -26,8 +26,8 @@ public:
      * @param sim The current simulation step
      */
     virtual void filter(const Simulation& sim) {
-        ComplexVector v = sim.getAtoms();
-        for (unsigned int i = 0; i < sim.getAtoms().size(); ++i) {
+        const ComplexVector& v = sim.getAtoms();
+        for (unsigned int i = 0; i < v.size(); ++i) {
             (*stream.get()) << static_cast<double>(i) / v.size()
                             << " "
                             << std::abs(v(i))
@@ -38,16 +38,6 @@ public:
     }
 
 private:
-    std::complex<double> greenFunction(const Simulation& sim, double energy) {
-        ComplexTridiagonalMatrix mat = sim.getSolver()->getHamiltonianMatrix();
-        std::complex<double> x = energy - mat(ComplexTridiagonalMatrix::Diagonal, mat.getSize() - 1);
-
-        for (unsigned int i = mat.getSize() - 2; i > 0; --i) {
-            x = energy - mat(ComplexTridiagonalMatrix::Diagonal, i) -  mat(ComplexTridiagonalMatrix::Upper, i) *  mat(ComplexTridiagonalMatrix::Upper, i) / x;
-        }
-        return std::complex<double>(1.0, 0) / x;
-    }
-
     std::shared_ptr<std::ostream> stream;
 };
 
@@ -73,8 +63,8 @@ public:
      * @param sim The current simulation step.
      */
     virtual void filter(const Simulation& sim) {
-        ComplexVector v = sim.getAtoms();
-        for (unsigned int i = 0; i < sim.getAtoms().size(); ++i) {
+        const ComplexVector& v = sim.getAtoms();
+        for (unsigned int i = 0; i < v.size(); ++i) {
             (*stream.get()) << static_cast<double>(i) / v.size()
                             << " "
                             << v(i).real()
@@ -111,8 +101,8 @@ public:
      * @param sim The current simulation step.
      */
     virtual void filter(const Simulation& sim) {
-        ComplexVector v = sim.getAtoms();
-        for (unsigned int i = 0; i < sim.getAtoms().size(); ++i) {
+        const ComplexVector& v = sim.getAtoms();
+        for (unsigned int i = 0; i < v.size(); ++i) {
             (*stream.get()) << static_cast<double>(i) / v.size()
                             << " "
                             << v(i).imag()
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <Python.h>
+
+/**
+ * @brief The PythonGILState class holds the global interpreter lock of python for its lifetime.
+ *        It may be used on any thread and also if the current thread already holds the lock.
+ */
+class PythonGILState
+{
+public:
+    PythonGILState() : state(PyGILState_Ensure()) {
+    }
+
+    ~PythonGILState() {
+        PyGILState_Release(state);
+    }
+
+    PythonGILState(const PythonGILState&) = delete;
+    PythonGILState& operator = (const PythonGILState&) = delete;
+
+private:
+    PyGILState_STATE state;
+};
+
+/**
+ * @brief The PythonGILRelease class releases the global interpreter lock of the current thread for its lifetime,
+ *        so other threads can call into python while this thread runs c++ code.
+ */
+class PythonGILRelease
+{
+public:
+    PythonGILRelease() : state(PyEval_SaveThread()) {
+    }
+
+    ~PythonGILRelease() {
+        PyEval_RestoreThread(state);
+    }
+
+    PythonGILRelease(const PythonGILRelease&) = delete;
+    PythonGILRelease& operator = (const PythonGILRelease&) = delete;
+
+private:
+    PyThreadState* state;
+};
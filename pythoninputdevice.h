@@ -3,6 +3,9 @@
 #include <boost/python.hpp>
 #include <boost/iostreams/stream.hpp>
 
+#include "pythongil.h"
+#include "profiler.h"
+
 /**
  * @brief The PythonInputDevice class is a helper class to construct an istream from an python object.
  *        This object must be extend the BaseIO class from python.
@@ -28,6 +31,7 @@ public:
     std::streamsize read(char_type* buffer, std::streamsize buffer_size)
     {
         namespace python = boost::python;
+        PythonGILState gil;
         boost::python::object py_data = object_.attr("read")(buffer_size);
         std::string data = python::extract<std::string>(py_data);
         if (data.empty()) {
@@ -67,9 +71,13 @@ public:
      */
     std::streamsize write(const char* buffer, std::streamsize buffer_size) {
         namespace python = boost::python;
+        ProfileScope scope(Profiler::PythonWrite);
+        PythonGILState gil;
         python::str data(buffer, buffer_size);
         python::extract<std::streamsize> bytes_written(object_.attr("write")(data));
-        return bytes_written.check() ? bytes_written : buffer_size;
+        const std::streamsize written = bytes_written.check() ? bytes_written : buffer_size;
+        scope.addBytes(written);
+        return written;
     }
 
     /**
@@ -77,6 +85,7 @@ public:
      * @return True if the data gets flushed successfully.
      */
     bool flush() {
+        PythonGILState gil;
         boost::python::object flush = object_.attr("flush");
         if (!flush.is_none()) {
             flush();
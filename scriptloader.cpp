@@ -2,6 +2,7 @@
 
 #include <utility>
 #include <boost/python.hpp>
+#include <boost/python/numpy.hpp>
 #include <boost/python/class.hpp>
 #include <boost/python/module_init.hpp>
 #include <boost/python/def.hpp>
@@ -13,14 +14,23 @@
 #include <boost/iostreams/stream_buffer.hpp>
 #include <boost/bind.hpp>
 
+#include <map>
+#include <limits>
+#include <exception>
+#include <stdexcept>
+#include <fstream>
+#include <sstream>
 #include <iostream>
+#include <algorithm>
 
 #include "wave.h"
 #include "Vector.h"
 #include "simulation.h"
+#include "batchsimulation.h"
 #include "observable.h"
 #include "gaussianwave.h"
 #include "pythoninputdevice.h"
+#include "pythongil.h"
 
 #include "potentialobservable.h"
 #include "properbilityoberservable.h"
@@ -28,13 +38,170 @@
 #include "expectationvalueobservable.h"
 
 #include "streamdensity.h"
+#include "trajectoryobservable.h"
+#include "greenfunctionobservable.h"
+#include "projectionobservable.h"
 
 #include "linearhamiltonian.h"
 #include "nonlinearhamiltonian.h"
+#include "timedependenthamiltonian.h"
+#include "feedbackhamiltonian.h"
 
 using namespace boost;
 using namespace python;
 namespace fs = boost::filesystem;
+namespace np = boost::python::numpy;
+
+namespace {
+
+/**
+ * @brief #compileScript Compile a script once per process, the same code object gets executed for every simulation.
+ *                       This keeps the code objects of the functions in the script alive and identical between runs.
+ * @param scriptFile The path to the python script.
+ * @return The compiled code object.
+ */
+boost::python::object compileScript(const std::string& scriptFile) {
+    static std::map<std::string, boost::python::object> scripts;
+    auto it = scripts.find(scriptFile);
+    if (it == scripts.end()) {
+        std::ifstream file(scriptFile.c_str());
+        if (!file) {
+            PyErr_SetString(PyExc_IOError, ("could not open script " + scriptFile).c_str());
+            throw_error_already_set();
+        }
+        std::stringstream source;
+        source << file.rdbuf();
+        boost::python::object builtins(borrowed(PyEval_GetBuiltins()));
+        it = scripts.insert(std::make_pair(scriptFile, builtins["compile"](source.str(), scriptFile, "exec"))).first;
+    }
+    return it->second;
+}
+
+void initializeNumpy() {
+    // numpy gets imported on the first use, so scripts without numpy still work
+    static bool initialized = false;
+    if (!initialized) {
+        np::initialize();
+        initialized = true;
+    }
+}
+
+/**
+ * @brief #sampleVectorizedPotential Sample a vectorized python potential function with a single call.
+ * @param func The python function, which gets the positions \f$ i / N \f$ of all atoms as a numpy array
+ *             and returns an array of the same length or a scalar.
+ * @param time The simulation time, which gets passed as second argument, or None for a static potential.
+ * @param values The array to write the atomCount values \f$ f(i / N) \f$ into.
+ * @param atomCount The atom count in the simulation.
+ */
+void sampleVectorizedPotential(boost::python::object func, boost::python::object time, double* values, unsigned int atomCount) {
+    initializeNumpy();
+    np::ndarray positions = np::empty(boost::python::make_tuple(atomCount), np::dtype::get_builtin<double>());
+    double* x = reinterpret_cast<double*>(positions.get_data());
+    for (unsigned int i = 0; i < atomCount; ++i) {
+        x[i] = static_cast<double>(i) / atomCount;
+    }
+
+    np::ndarray result = np::from_object(time.is_none() ? func(positions) : func(positions, time), np::dtype::get_builtin<double>(), 0, 1,
+                                         np::ndarray::C_CONTIGUOUS | np::ndarray::ALIGNED);
+    const double* data = reinterpret_cast<const double*>(result.get_data());
+    if (result.get_nd() == 0) {
+        std::fill(values, values + atomCount, data[0]);
+        return;
+    }
+    if (static_cast<unsigned int>(result.shape(0)) != atomCount) {
+        PyErr_SetString(PyExc_ValueError, "the vectorized potential must return one value per atom");
+        throw_error_already_set();
+    }
+    std::copy(data, data + atomCount, values);
+}
+
+/**
+ * @brief #sampleVectorizedPotential Sample a static vectorized python potential function with a single call.
+ * @param func The python function, see above.
+ * @param atomCount The atom count in the simulation.
+ * @return The values \f$ f(i / N) \f$ for every atom \f$ i \f$.
+ */
+std::vector<double> sampleVectorizedPotential(boost::python::object func, unsigned int atomCount) {
+    std::vector<double> values(atomCount);
+    sampleVectorizedPotential(func, boost::python::object(), values.data(), atomCount);
+    return values;
+}
+
+/**
+ * @brief The PythonTimePotential class A time dependent potential \f$ f(x, t) \f$ from python, which gets
+ *        sampled with one vectorized call per time. The function must accept a numpy array of positions.
+ */
+class PythonTimePotential : public Potential {
+public:
+    PythonTimePotential(boost::python::object f) : func(f) {
+    }
+
+    virtual double operator () (double x, double t = 0) const {
+        PythonGILState gil;
+        return boost::python::call<double>(func.ptr(), x, t);
+    }
+
+    virtual void sample(double* values, unsigned int atomCount, double t = 0) const {
+        PythonGILState gil;
+        sampleVectorizedPotential(func, boost::python::object(t), values, atomCount);
+    }
+
+    virtual bool isTimeDependent() const { return true; }
+
+private:
+    boost::python::object func;
+};
+
+/**
+ * @brief The PythonPotential struct A potential function together with its samples. The same object can be
+ *        passed to a solver and to the PotentialObservable, which then share a single sampling of the grid.
+ */
+struct PythonPotential {
+    PythonPotential(boost::python::object f, bool Vectorized)
+        : func(f), vectorized(Vectorized) {
+    }
+
+    const std::vector<double>& sample(unsigned int atomCount) {
+        if (values.size() != atomCount) {
+            if (vectorized) {
+                values = sampleVectorizedPotential(func, atomCount);
+            } else {
+                values = HamiltonianSolver<std::complex<double>>::samplePotential(
+                            [this](double x) { return boost::python::call<double>(func.ptr(), x); }, atomCount);
+            }
+        }
+        return values;
+    }
+
+    boost::python::object func;
+    bool vectorized;
+    std::vector<double> values;
+};
+
+/**
+ * @brief #samplePotential Sample a python potential function at the positions of the atoms.
+ *                         A Potential object samples once and keeps its samples, so only the solvers and observables
+ *                         which get the same Potential object share a sampling. A plain python function and a native
+ *                         potential get sampled on every call.
+ * @param func The python function of the form \f$ f:[0,1]\rightarrow\mathbb{R} \f$, a Potential object or a native potential.
+ * @param atomCount The atom count in the simulation.
+ * @return The values \f$ f(i / N) \f$ for every atom \f$ i \f$.
+ */
+std::vector<double> samplePotential(boost::python::object func, unsigned int atomCount) {
+    extract<PythonPotential&> potential(func);
+    if (potential.check()) {
+        return potential().sample(atomCount);
+    }
+    extract<const Potential&> native(func);
+    if (native.check()) {
+        return native().sample(atomCount);
+    }
+    return HamiltonianSolver<std::complex<double>>::samplePotential(
+                [&func](double x) { return boost::python::call<double>(func.ptr(), x); }, atomCount);
+}
+
+}
 
 
 class PythonSimulation;
@@ -46,18 +213,22 @@ struct HamiltonianSolverCallback : public HamiltonianSolver<T> {
     }
 
     virtual Vector<T> solve(const Vector<T>& current) {
+        PythonGILState gil;
         return call_method<Vector<T>>(self, "solve", current);
     }
 
     virtual TridiagonalMatrix<T> getHamiltonianMatrix() {
+        PythonGILState gil;
         return call_method<TridiagonalMatrix<T>>(self, "getHamiltonianMatrix");
     }
 
     virtual TridiagonalMatrix<T> getLeftMatrix() {
+        PythonGILState gil;
         return call_method<TridiagonalMatrix<T>>(self, "getLeftMatrix");
     }
 
     virtual TridiagonalMatrix<T> getRightMatrix() {
+        PythonGILState gil;
         return call_method<TridiagonalMatrix<T>>(self, "getRightMatrix");
     }
 
@@ -137,6 +308,20 @@ public:
     PythonSimulation(Simulation* sim) : Simulation(*sim) {
     }
 
+    /**
+     * @brief #run Run the simulation without the global interpreter lock, so observables on background threads
+     *             can call into python. Every python callback acquires the lock on its own.
+     */
+    void run() {
+        PythonGILRelease release;
+        Simulation::run();
+    }
+
+    bool relax() {
+        PythonGILRelease release;
+        return Simulation::relax();
+    }
+
     void addFilter(boost::python::object ob) {
         Observable& filter = extract<Observable&>(ob);
         filters.push_back(std::pair<boost::python::object, Observable&>(ob, filter));
@@ -155,11 +340,48 @@ public:
         Simulation::setSolver(std::shared_ptr<ComplexHamiltonianSolver>(&result, [] (ComplexHamiltonianSolver*) {}));
     }
 
+protected:
+    virtual Simulation* createSnapshot() const {
+        return new PythonSimulation(const_cast<PythonSimulation*>(this));
+    }
+
 private:
     std::vector<std::pair<boost::python::object, ComplexHamiltonianSolver&>> solver;
     std::vector<std::pair<boost::python::object, Observable&>> filters;
 };
 
+/**
+ * @brief The PythonBatchSimulation class
+ */
+class PythonBatchSimulation : public BatchSimulation {
+public:
+    PythonBatchSimulation(PythonSimulation* sim, unsigned int members)
+        : BatchSimulation(createMembers(sim, members)) {
+    }
+
+    void run() {
+        PythonGILRelease release;
+        BatchSimulation::run();
+    }
+
+    PythonSimulation& getPythonMember(unsigned int member) {
+        return static_cast<PythonSimulation&>(getMember(member));
+    }
+
+private:
+    static std::vector<std::shared_ptr<Simulation>> createMembers(PythonSimulation* sim, unsigned int count) {
+        // the members share the solver, which is kept alive by the python simulation
+        std::shared_ptr<ComplexHamiltonianSolver> solver(sim->getSolver(), [] (ComplexHamiltonianSolver*) {});
+        std::vector<std::shared_ptr<Simulation>> members;
+        for (unsigned int i = 0; i < count; ++i) {
+            Simulation member(sim->getParameter(), solver);
+            member.setThreadCount(sim->getThreadCount());
+            members.push_back(std::make_shared<PythonSimulation>(&member));
+        }
+        return members;
+    }
+};
+
 /*class PythonObservable : public Observable {
 public:
     PythonObservable(CheckTime time) : Observable(time) {
@@ -232,18 +454,18 @@ struct PythonPotentialObservable : public Observable {
         : Observable(CheckTime::Startup) {
         func = f;
         stream.reset(new boost::iostreams::stream<PythonOutputDevice>(output));
-        obs.reset(new PotentialObservable(*stream.get(), boost::bind(&PythonPotentialObservable::potential, this, _1)));
     }
 
     virtual void filter(const Simulation& sim) {
+        {
+            // only a Potential object shares the samples of a solver, a plain function gets sampled here
+            PythonGILState gil;
+            obs.reset(new PotentialObservable(*stream.get(), samplePotential(func, sim.getAtoms().size())));
+        }
         obs->filter(sim);
         stream->flush();
     }
 private:
-    double potential(double x) {
-        return boost::python::call<double>(func.ptr(), x);
-    }
-
     std::shared_ptr<PotentialObservable> obs;
     std::shared_ptr<std::ostream> stream;
     boost::python::object func;
@@ -267,10 +489,10 @@ private:
 };
 
 struct PythonEnergyValueObservable : public Observable {
-    PythonEnergyValueObservable(boost::python::object output)
+    PythonEnergyValueObservable(boost::python::object output, unsigned int lowest, double lower, double upper, unsigned int threads)
         : Observable(CheckTime::Startup) {
         stream.reset(new boost::iostreams::stream<PythonOutputDevice>(output));
-        obs.reset(new EnergyEigenvalueObservable(*stream.get()));
+        obs.reset(new EnergyEigenvalueObservable(*stream.get(), lowest, lower, upper, threads));
     }
 
     virtual void filter(const Simulation& sim) {
@@ -288,6 +510,7 @@ struct PythonExpectationValueObservable : public Observable {
         : Observable(CheckTime::Iteration) {
         stream.reset(new boost::iostreams::stream<PythonOutputDevice>(output));
         obs.reset(new ExpectationValueObservable(*stream.get()));
+        setSynchronous(true);
     }
 
     virtual void filter(const Simulation& sim) {
@@ -299,19 +522,67 @@ private:
     std::shared_ptr<std::ostream> stream;
 };
 
+struct PythonGreenFunctionObservable : public Observable {
+    PythonGreenFunctionObservable(boost::python::object output, boost::python::object energies, GreenFunctionObservable::Quantity mode,
+                                  unsigned int site, double broadening, unsigned int threads, CheckTime time)
+        : Observable(time) {
+        stream.reset(new boost::iostreams::stream<PythonOutputDevice>(output));
+        obs.reset(new GreenFunctionObservable(*stream.get(), toDoubles(energies), mode, site, broadening, threads, time));
+        setSynchronous(true);
+    }
+
+    virtual void filter(const Simulation& sim) {
+        obs->filter(sim);
+        stream->flush();
+    }
+
+    static std::vector<double> toDoubles(boost::python::object values) {
+        return std::vector<double>(boost::python::stl_input_iterator<double>(values), boost::python::stl_input_iterator<double>());
+    }
+private:
+    std::shared_ptr<GreenFunctionObservable> obs;
+    std::shared_ptr<std::ostream> stream;
+};
+
+
+struct PythonProjectionObservable : public Observable {
+    PythonProjectionObservable(boost::python::object output, unsigned int lowest, double lower, double upper, unsigned int threads)
+        : Observable(CheckTime::Iteration) {
+        stream.reset(new boost::iostreams::stream<PythonOutputDevice>(output));
+        obs.reset(new ProjectionObservable(*stream.get(), lowest, lower, upper, threads));
+        setSynchronous(true);
+    }
+
+    virtual void filter(const Simulation& sim) {
+        obs->filter(sim);
+        stream->flush();
+    }
+private:
+    std::shared_ptr<ProjectionObservable> obs;
+    std::shared_ptr<std::ostream> stream;
+};
+
 
 template <typename T>
 class PythonLinearHamiltonianSolver : public HamiltonianSolver<T> {
 public:
     PythonLinearHamiltonianSolver(PythonSimulation* sim, boost::python::object f)
         : func(f) {
-        solver.reset(new LinearHamiltonianSolver<T>(sim->getParameter(), boost::bind(&PythonLinearHamiltonianSolver<T>::potential, this, _1)));
+        solver.reset(new LinearHamiltonianSolver<T>(sim->getParameter(), samplePotential(func, sim->getParameter().atomCount)));
     }
 
     virtual Vector<T> solve(const Vector<T>& current) {
         return solver->solve(current);
     }
 
+    virtual void step(Vector<T>& state, typename HamiltonianSolver<T>::Workspace& workspace) {
+        solver->step(state, workspace);
+    }
+
+    virtual void step(VectorBatch<T>& states, typename HamiltonianSolver<T>::Workspace& workspace) {
+        solver->step(states, workspace);
+    }
+
     virtual TridiagonalMatrix<T> getHamiltonianMatrix() {
         return solver->getHamiltonianMatrix();
     }
@@ -324,11 +595,15 @@ public:
         return solver->getRightMatrix();
     }
 
-private:
-    double potential(double x) {
-        return boost::python::call<double>(func.ptr(), x);
+    virtual bool setImaginaryTime(double lambda) {
+        return solver->setImaginaryTime(lambda);
     }
 
+    virtual void applyHamiltonian(const Vector<T>& state, Vector<T>& result) {
+        solver->applyHamiltonian(state, result);
+    }
+
+private:
     boost::python::object func;
     std::shared_ptr<LinearHamiltonianSolver<T>> solver;
 };
@@ -336,15 +611,24 @@ private:
 template <typename T>
 class PythonNonLinearHamiltonianSolver : public HamiltonianSolver<T> {
 public:
-    PythonNonLinearHamiltonianSolver(PythonSimulation* sim, boost::python::object f, double factor)
+    PythonNonLinearHamiltonianSolver(PythonSimulation* sim, boost::python::object f, double factor,
+                                     typename NonLinearHamiltonianSolver<T>::NonLinearity mode = NonLinearHamiltonianSolver<T>::Global)
         : func(f) {
-        solver.reset(new NonLinearHamiltonianSolver<T>(sim->getParameter(), boost::bind(&PythonNonLinearHamiltonianSolver<T>::potential, this, _1), factor));
+        solver.reset(new NonLinearHamiltonianSolver<T>(sim->getParameter(), samplePotential(func, sim->getParameter().atomCount), factor, mode));
     }
 
     virtual Vector<T> solve(const Vector<T>& current) {
         return solver->solve(current);
     }
 
+    virtual void step(Vector<T>& state, typename HamiltonianSolver<T>::Workspace& workspace) {
+        solver->step(state, workspace);
+    }
+
+    virtual void step(VectorBatch<T>& states, typename HamiltonianSolver<T>::Workspace& workspace) {
+        solver->step(states, workspace);
+    }
+
     virtual TridiagonalMatrix<T> getHamiltonianMatrix() {
         return solver->getHamiltonianMatrix();
     }
@@ -357,21 +641,78 @@ public:
         return solver->getRightMatrix();
     }
 
-private:
-    double potential(double x) {
-        return boost::python::call<double>(func.ptr(), x);
+    virtual bool setImaginaryTime(double lambda) {
+        return solver->setImaginaryTime(lambda);
+    }
+
+    virtual void applyHamiltonian(const Vector<T>& state, Vector<T>& result) {
+        solver->applyHamiltonian(state, result);
     }
 
+private:
     boost::python::object func;
     std::shared_ptr<NonLinearHamiltonianSolver<T>> solver;
 };
 
+template <typename T>
+class PythonTimeDependentHamiltonianSolver : public HamiltonianSolver<T> {
+public:
+    PythonTimeDependentHamiltonianSolver(PythonSimulation* sim, boost::python::object f, double startTime = 0)
+        : func(f) {
+        std::shared_ptr<Potential> potential;
+        extract<std::shared_ptr<Potential>> native(func);
+        if (native.check()) {
+            potential = native();
+        } else {
+            potential = std::make_shared<PythonTimePotential>(func);
+        }
+        solver.reset(new TimeDependentHamiltonianSolver<T>(sim->getParameter(), potential, startTime));
+    }
+
+    virtual Vector<T> solve(const Vector<T>& current) {
+        return solver->solve(current);
+    }
+
+    virtual void step(Vector<T>& state, typename HamiltonianSolver<T>::Workspace& workspace) {
+        solver->step(state, workspace);
+    }
+
+    virtual void step(VectorBatch<T>& states, typename HamiltonianSolver<T>::Workspace& workspace) {
+        solver->step(states, workspace);
+    }
+
+    virtual TridiagonalMatrix<T> getHamiltonianMatrix() {
+        return solver->getHamiltonianMatrix();
+    }
+
+    virtual TridiagonalMatrix<T> getLeftMatrix() {
+        return solver->getLeftMatrix();
+    }
+
+    virtual TridiagonalMatrix<T> getRightMatrix() {
+        return solver->getRightMatrix();
+    }
+
+    double getTime() const {
+        return solver->getTime();
+    }
+
+    void setTime(double time) {
+        solver->setTime(time);
+    }
+
+private:
+    boost::python::object func;
+    std::shared_ptr<TimeDependentHamiltonianSolver<T>> solver;
+};
+
 struct WaveCallback : Wave<std::complex<double>> {
     WaveCallback(PyObject *p)
         : self(p) {
     }
 
     std::complex<double> getDisplacement(unsigned int index) const {
+        PythonGILState gil;
         return call_method<unsigned int>(self, "getDisplacement", index);
     }
 
@@ -388,14 +729,261 @@ struct ObservableCallback : Observable {
     }
 
     virtual void filter(const Simulation& sim) {
+        PythonGILState gil;
         Simulation* k = const_cast<Simulation*>(&sim);
-        filter(boost::shared_ptr<PythonSimulation>(static_cast<PythonSimulation*>(k), [&](PythonSimulation* sim) {}));
+        try {
+            filter(boost::shared_ptr<PythonSimulation>(static_cast<PythonSimulation*>(k), [&](PythonSimulation* sim) {}));
+        } catch (error_already_set&) {
+            // the python error belongs to this thread, which may be a thread of an ObservablePipeline
+            PyErr_Print();
+            throw std::runtime_error("python observable failed");
+        }
     }
 
     PyObject* self;
 };
 
 
+//NumPy views, which alias the memory of the c++ objects
+template <typename T>
+np::ndarray createArray(const T* data, unsigned int size, boost::python::object owner, bool writable) {
+    initializeNumpy();
+    const np::dtype type = np::dtype::get_builtin<T>();
+    const boost::python::tuple shape = boost::python::make_tuple(size);
+    const boost::python::tuple strides = boost::python::make_tuple(sizeof(T));
+    if (writable) {
+        return np::from_data(const_cast<T*>(data), type, shape, strides, owner);
+    }
+    return np::from_data(data, type, shape, strides, owner);
+}
+
+template <typename T>
+np::ndarray vectorArray(boost::python::object self, bool writable) {
+    Vector<T>& vec = extract<Vector<T>&>(self);
+    return createArray(vec.data(), vec.size(), self, writable);
+}
+
+template <typename T>
+np::ndarray matrixArray(boost::python::object self, typename TridiagonalMatrix<T>::Line line, bool writable) {
+    TridiagonalMatrix<T>& mat = extract<TridiagonalMatrix<T>&>(self);
+    return createArray(mat.data(line), mat.getSize(), self, writable);
+}
+
+np::ndarray simulationAtomsArray(boost::python::object self) {
+    const PythonSimulation& sim = extract<PythonSimulation&>(self);
+    return createArray(sim.getAtoms().data(), sim.getAtoms().size(), self, false);
+}
+
+//Native potentials for python
+double evaluatePotential(const Potential& potential, double x, double t) {
+    return potential(x, t);
+}
+
+np::ndarray samplePotentialArray(const Potential& potential, unsigned int atomCount, double t) {
+    initializeNumpy();
+    np::ndarray values = np::empty(boost::python::make_tuple(atomCount), np::dtype::get_builtin<double>());
+    potential.sample(reinterpret_cast<double*>(values.get_data()), atomCount, t);
+    return values;
+}
+
+//Green functions for python
+std::complex<double> evaluateGreenFunction(const GreenFunction& green, double energy, unsigned int site) {
+    if (site >= green.getSize()) {
+        throw std::out_of_range("the site is outside of the hamiltonian");
+    }
+    return green(energy, site);
+}
+
+ThreadPool* createThreadPool(unsigned int threads) {
+    return new ThreadPool(threads > 0 ? threads : std::max(1u, std::thread::hardware_concurrency()));
+}
+
+np::ndarray greenFunctionElement(const GreenFunction& green, boost::python::object energies, unsigned int site, unsigned int threads) {
+    if (site >= green.getSize()) {
+        throw std::out_of_range("the site is outside of the hamiltonian");
+    }
+    initializeNumpy();
+    const std::vector<double> values = PythonGreenFunctionObservable::toDoubles(energies);
+    np::ndarray result = np::empty(boost::python::make_tuple(values.size()), np::dtype::get_builtin<std::complex<double>>());
+    {
+        PythonGILRelease release;
+        std::unique_ptr<ThreadPool> pool(createThreadPool(threads));
+        green.element(values.data(), values.size(), site, reinterpret_cast<std::complex<double>*>(result.get_data()), pool.get());
+    }
+    return result;
+}
+
+np::ndarray greenFunctionLocalDensity(const GreenFunction& green, boost::python::object energies, unsigned int threads) {
+    initializeNumpy();
+    const std::vector<double> values = PythonGreenFunctionObservable::toDoubles(energies);
+    np::ndarray result = np::empty(boost::python::make_tuple(values.size(), green.getSize()), np::dtype::get_builtin<double>());
+    {
+        PythonGILRelease release;
+        std::unique_ptr<ThreadPool> pool(createThreadPool(threads));
+        green.localDensity(values.data(), values.size(), reinterpret_cast<double*>(result.get_data()), pool.get());
+    }
+    return result;
+}
+
+np::ndarray greenFunctionDensity(const GreenFunction& green, boost::python::object energies, unsigned int threads) {
+    initializeNumpy();
+    const std::vector<double> values = PythonGreenFunctionObservable::toDoubles(energies);
+    np::ndarray result = np::empty(boost::python::make_tuple(values.size()), np::dtype::get_builtin<double>());
+    {
+        PythonGILRelease release;
+        std::unique_ptr<ThreadPool> pool(createThreadPool(threads));
+        green.density(values.data(), values.size(), reinterpret_cast<double*>(result.get_data()), pool.get());
+    }
+    return result;
+}
+
+//Eigenvalues for python
+np::ndarray matrixEigenvalues(const TridiagonalMatrix<std::complex<double>>& matrix, unsigned int lowest, double lower, double upper, unsigned int threads) {
+    initializeNumpy();
+    const TridiagonalEigensolver solver = matrix.getEigensolver();
+    const std::pair<unsigned int, unsigned int> range = solver.window(lower, upper);
+    const unsigned int count = lowest > 0 ? std::min(lowest, range.second - range.first) : range.second - range.first;
+    np::ndarray result = np::empty(boost::python::make_tuple(count), np::dtype::get_builtin<double>());
+    {
+        PythonGILRelease release;
+        std::unique_ptr<ThreadPool> pool(createThreadPool(threads));
+        const std::vector<double> values = solver.eigenvalues(range.first, count, pool.get());
+        std::copy(values.begin(), values.end(), reinterpret_cast<double*>(result.get_data()));
+    }
+    return result;
+}
+
+struct PythonEigenbasis {
+    PythonEigenbasis(const TridiagonalMatrix<std::complex<double>>& hamiltonian, unsigned int lowest, double lower, double upper, unsigned int threads)
+        : pool(createThreadPool(threads)) {
+        PythonGILRelease release;
+        basis.reset(new Eigenbasis(hamiltonian, lowest, lower, upper, pool.get()));
+    }
+
+    np::ndarray eigenvalues() const {
+        initializeNumpy();
+        const std::vector<double>& values = basis->getEigenvalues();
+        np::ndarray result = np::empty(boost::python::make_tuple(values.size()), np::dtype::get_builtin<double>());
+        std::copy(values.begin(), values.end(), reinterpret_cast<double*>(result.get_data()));
+        return result;
+    }
+
+    Vector<std::complex<double>> eigenvector(unsigned int n) const {
+        if (n >= basis->getCount()) {
+            throw std::out_of_range("the eigenstate is not in the basis");
+        }
+        return basis->getEigenvector(n);
+    }
+
+    np::ndarray project(const Vector<std::complex<double>>& state) {
+        if (state.size() != basis->getSize()) {
+            throw std::invalid_argument("the state does not match the size of the hamiltonian");
+        }
+        initializeNumpy();
+        np::ndarray result = np::empty(boost::python::make_tuple(basis->getCount()), np::dtype::get_builtin<std::complex<double>>());
+        {
+            PythonGILRelease release;
+            basis->project(state, reinterpret_cast<std::complex<double>*>(result.get_data()), pool.get());
+        }
+        return result;
+    }
+
+    unsigned int getFirst() const { return basis->getFirst(); }
+    unsigned int getCount() const { return basis->getCount(); }
+
+private:
+    std::unique_ptr<ThreadPool> pool;
+    std::unique_ptr<Eigenbasis> basis;
+};
+
+//Feedback potentials for python
+class PythonFeedback : public FeedbackPotential<std::complex<double>> {
+public:
+    PythonFeedback(boost::python::object f) : func(f) {
+    }
+
+    virtual void evaluate(const Vector<std::complex<double>>& state, double* values) override {
+        // the views are only valid during the call, the function must not keep them
+        PythonGILState gil;
+        std::fill(values, values + state.size(), 0.0);
+        func(createArray(state.data(), state.size(), boost::python::object(), false),
+             createArray(values, state.size(), boost::python::object(), true));
+    }
+
+private:
+    boost::python::object func;
+};
+
+std::shared_ptr<FeedbackPotential<std::complex<double>>> toFeedback(boost::python::object feedback) {
+    extract<std::shared_ptr<FeedbackPotential<std::complex<double>>>> native(feedback);
+    if (native.check()) {
+        return native();
+    }
+    return std::make_shared<PythonFeedback>(feedback);
+}
+
+template <typename T>
+class PythonFeedbackHamiltonianSolver : public HamiltonianSolver<T> {
+public:
+    using HamiltonianSolver<T>::step;
+
+    PythonFeedbackHamiltonianSolver(PythonSimulation* sim, boost::python::object f, boost::python::object feedback)
+        : func(f) {
+        solver.reset(new FeedbackHamiltonianSolver<T>(sim->getParameter(), samplePotential(func, sim->getParameter().atomCount)));
+        addFeedback(feedback);
+    }
+
+    void addFeedback(boost::python::object feedback) {
+        feedbacks.append(feedback);
+        solver->addFeedback(toFeedback(feedback));
+    }
+
+    virtual Vector<T> solve(const Vector<T>& current) {
+        return solver->solve(current);
+    }
+
+    virtual void step(Vector<T>& state, typename HamiltonianSolver<T>::Workspace& workspace) {
+        solver->step(state, workspace);
+    }
+
+    virtual TridiagonalMatrix<T> getHamiltonianMatrix() {
+        return solver->getHamiltonianMatrix();
+    }
+
+    virtual TridiagonalMatrix<T> getLeftMatrix() {
+        return solver->getLeftMatrix();
+    }
+
+    virtual TridiagonalMatrix<T> getRightMatrix() {
+        return solver->getRightMatrix();
+    }
+
+private:
+    boost::python::object func;
+    boost::python::list feedbacks;
+    std::shared_ptr<FeedbackHamiltonianSolver<T>> solver;
+};
+
+//Trajectory access for python
+np::ndarray readTrajectoryFrame(TrajectoryReader& reader, uint64_t frame, Trajectory::Channel channel) {
+    initializeNumpy();
+    np::ndarray values = np::empty(boost::python::make_tuple(reader.getHeader().atomCount), np::dtype::get_builtin<double>());
+    reader.readFrame(frame, channel, reinterpret_cast<double*>(values.get_data()));
+    return values;
+}
+
+void writeTrajectoryGnuplot(TrajectoryReader& reader, boost::python::object output, Trajectory::Channel channel) {
+    boost::iostreams::stream<PythonOutputDevice> stream(output);
+    reader.writeGnuplot(stream, channel);
+    stream.flush();
+}
+
+unsigned int getTrajectoryAtomCount(TrajectoryReader& reader) { return reader.getHeader().atomCount; }
+unsigned int getTrajectoryChannels(TrajectoryReader& reader) { return reader.getHeader().channels; }
+double getTrajectoryDx(TrajectoryReader& reader) { return reader.getHeader().dx; }
+double getTrajectoryDt(TrajectoryReader& reader) { return reader.getHeader().dt; }
+double getTrajectoryMass(TrajectoryReader& reader) { return reader.getHeader().mass; }
+
 BOOST_PYTHON_MODULE(CrankNicolson) {
     // math stuff
     class_<Vector<std::complex<double>>>("Vector", init<unsigned int>())
@@ -409,6 +997,7 @@ BOOST_PYTHON_MODULE(CrankNicolson) {
             .def("length", &Vector<std::complex<double>>::length)
             .def("normalize", &Vector<std::complex<double>>::normalised)
             .def("dot", &Vector<std::complex<double>>::dot)
+            .def("asArray", &vectorArray<std::complex<double>>, (boost::python::arg("self"), boost::python::arg("writable") = true))
     ;
 
     enum_<typename TridiagonalMatrix<std::complex<double>>::Line>("Line")
@@ -427,6 +1016,11 @@ BOOST_PYTHON_MODULE(CrankNicolson) {
             .def("identity", &TridiagonalMatrix<std::complex<double>>::identity)
             .def("solve", &TridiagonalMatrix<std::complex<double>>::solve)
             .def("size", &TridiagonalMatrix<std::complex<double>>::getSize)
+            .def("asArray", &matrixArray<std::complex<double>>, (boost::python::arg("self"), boost::python::arg("line"), boost::python::arg("writable") = true))
+            .def("eigenvalues", &matrixEigenvalues, (boost::python::arg("self"), boost::python::arg("lowest") = 0,
+                                                     boost::python::arg("lower") = -std::numeric_limits<double>::infinity(),
+                                                     boost::python::arg("upper") = std::numeric_limits<double>::infinity(),
+                                                     boost::python::arg("threads") = 0))
             .staticmethod("identity")
     ;
 
@@ -443,6 +1037,7 @@ BOOST_PYTHON_MODULE(CrankNicolson) {
             .def_readonly("lambda", &SimulationParameter::lambda)
             .def_readonly("iterations", &SimulationParameter::iterations)
             .def_readonly("atomCount", &SimulationParameter::atomCount)
+            .def_readonly("threads", &SimulationParameter::threads)
     ;
 
     class_<PythonSimulation, boost::noncopyable, boost::shared_ptr<PythonSimulation>>("Simulation", no_init)
@@ -451,14 +1046,36 @@ BOOST_PYTHON_MODULE(CrankNicolson) {
             .def("addWave", &PythonSimulation::addWave)
             .def("addFilter", &PythonSimulation::addFilter)
             .def("run", &PythonSimulation::run)
-            .def("getParameter", &PythonSimulation::getParameter)
-            .def("getAtoms", &PythonSimulation::getAtoms)
+            .def("setThreadCount", &PythonSimulation::setThreadCount)
+            .def("getThreadCount", &PythonSimulation::getThreadCount)
+            .def("setAsyncObservers", &PythonSimulation::setAsyncObservers, (boost::python::arg("threads"), boost::python::arg("snapshots") = 4))
+            .def("getAsyncObserverThreads", &PythonSimulation::getAsyncObserverThreads)
+            .def("getParameter", &PythonSimulation::getParameter, return_value_policy<copy_const_reference>())
+            .def("getAtoms", &PythonSimulation::getAtoms, return_value_policy<copy_const_reference>())
+            .def("getIteration", &PythonSimulation::getIteration)
+            .def("getAtomsArray", &simulationAtomsArray)
+            .def("getPotential", &PythonSimulation::getPotential)
+            .def("setImaginaryTime", &PythonSimulation::setImaginaryTime, (boost::python::arg("iterations"), boost::python::arg("tolerance") = 1e-10,
+                                                                         boost::python::arg("timeStep") = 0.0, boost::python::arg("interval") = 10))
+            .def("relax", &PythonSimulation::relax)
+            .def("getRelaxationIterations", &PythonSimulation::getRelaxationIterations)
+            .def("getRelaxationEnergy", &PythonSimulation::getRelaxationEnergy)
+            .def("getRelaxationResidual", &PythonSimulation::getRelaxationResidual)
+    ;
+    class_<PythonBatchSimulation, boost::noncopyable>("BatchSimulation", init<PythonSimulation*, unsigned int>())
+            .def("getMember", &PythonBatchSimulation::getPythonMember, return_internal_reference<>())
+            .def("getMemberCount", &PythonBatchSimulation::getMemberCount)
+            .def("run", &PythonBatchSimulation::run)
     ;
     class_<Wave<std::complex<double>>, boost::noncopyable, boost::shared_ptr<WaveCallback>>("Wave")
             .def("getDisplacement", &Wave<std::complex<double>>::getDisplacement)
     ;
     class_<Observable, boost::noncopyable, boost::shared_ptr<ObservableCallback>>("Observable", init<Observable::CheckTime>())
             .def("filter", &Observable::filter)
+            .def("setStride", &Observable::setStride)
+            .def("setWindow", &Observable::setWindow, (boost::python::arg("start"), boost::python::arg("stop") = -1))
+            .def("setTimeInterval", &Observable::setTimeInterval)
+            .def("setSynchronous", &Observable::setSynchronous)
     ;
     class_<HamiltonianSolver<std::complex<double>>, boost::noncopyable, boost::shared_ptr<HamiltonianSolverCallback<std::complex<double>>>>("HamiltonianSolver", init<>())
             .def("solve", &HamiltonianSolver<std::complex<double>>::solve)
@@ -477,42 +1094,182 @@ BOOST_PYTHON_MODULE(CrankNicolson) {
     class_<PythonPotentialObservable, bases<Observable>>("PotentialObservable", init<boost::python::object, boost::python::object>());
     class_<PythonProperbilityFluxObservable, bases<Observable>>("ProperbilityFluxObservable", init<boost::python::object>());
     class_<PythonExpectationValueObservable, bases<Observable>>("ExpectationValueObservable", init<boost::python::object>());
-    class_<PythonEnergyValueObservable, bases<Observable>>("EnergyEigenvalueObservable", init<boost::python::object>());
+    class_<PythonEnergyValueObservable, bases<Observable>>("EnergyEigenvalueObservable",
+            init<boost::python::object, unsigned int, double, double, unsigned int>(
+                (boost::python::arg("output"), boost::python::arg("lowest") = 0,
+                 boost::python::arg("lower") = -std::numeric_limits<double>::infinity(),
+                 boost::python::arg("upper") = std::numeric_limits<double>::infinity(), boost::python::arg("threads") = 0)));
+
+    class_<PythonProjectionObservable, bases<Observable>>("ProjectionObservable",
+            init<boost::python::object, unsigned int, double, double, unsigned int>(
+                (boost::python::arg("output"), boost::python::arg("lowest") = 10,
+                 boost::python::arg("lower") = -std::numeric_limits<double>::infinity(),
+                 boost::python::arg("upper") = std::numeric_limits<double>::infinity(), boost::python::arg("threads") = 0)));
+    class_<PythonEigenbasis, boost::noncopyable>("Eigenbasis",
+            init<const TridiagonalMatrix<std::complex<double>>&, unsigned int, double, double, unsigned int>(
+                (boost::python::arg("hamiltonian"), boost::python::arg("lowest") = 10,
+                 boost::python::arg("lower") = -std::numeric_limits<double>::infinity(),
+                 boost::python::arg("upper") = std::numeric_limits<double>::infinity(), boost::python::arg("threads") = 0)))
+            .def("eigenvalues", &PythonEigenbasis::eigenvalues)
+            .def("eigenvector", &PythonEigenbasis::eigenvector)
+            .def("project", &PythonEigenbasis::project)
+            .def("getFirst", &PythonEigenbasis::getFirst)
+            .def("getCount", &PythonEigenbasis::getCount)
+    ;
+
+    //green functions
+    enum_<GreenFunctionObservable::Quantity>("GreenQuantity")
+            .value("Element", GreenFunctionObservable::Element)
+            .value("LocalDensity", GreenFunctionObservable::LocalDensity)
+            .value("Density", GreenFunctionObservable::Density)
+    ;
+    class_<PythonGreenFunctionObservable, bases<Observable>>("GreenFunctionObservable",
+            init<boost::python::object, boost::python::object, GreenFunctionObservable::Quantity, unsigned int, double, unsigned int, Observable::CheckTime>(
+                (boost::python::arg("output"), boost::python::arg("energies"), boost::python::arg("quantity") = GreenFunctionObservable::Element,
+                 boost::python::arg("site") = 1, boost::python::arg("broadening") = 1e-3, boost::python::arg("threads") = 0,
+                 boost::python::arg("time") = Observable::Startup)));
+    class_<GreenFunction>("GreenFunction", init<const TridiagonalMatrix<std::complex<double>>&, double>((boost::python::arg("hamiltonian"), boost::python::arg("broadening") = 1e-3)))
+            .def("__call__", &evaluateGreenFunction, (boost::python::arg("energy"), boost::python::arg("site")))
+            .def("element", &greenFunctionElement, (boost::python::arg("energies"), boost::python::arg("site"), boost::python::arg("threads") = 0))
+            .def("localDensity", &greenFunctionLocalDensity, (boost::python::arg("energies"), boost::python::arg("threads") = 0))
+            .def("density", &greenFunctionDensity, (boost::python::arg("energies"), boost::python::arg("threads") = 0))
+            .def("getSize", &GreenFunction::getSize)
+            .def("getBroadening", &GreenFunction::getBroadening)
+    ;
+
+    //binary trajectories
+    enum_<Trajectory::Channel>("Channel")
+            .value("Amplitude", Trajectory::Amplitude)
+            .value("Real", Trajectory::Real)
+            .value("Imaginary", Trajectory::Imaginary)
+    ;
+    class_<TrajectoryObservable, bases<Observable>, boost::noncopyable>("TrajectoryObservable", init<std::string, optional<unsigned int>>())
+            .def("close", &TrajectoryObservable::close)
+    ;
+    class_<TrajectoryReader, boost::noncopyable>("TrajectoryReader", init<std::string>())
+            .def("readFrame", &readTrajectoryFrame)
+            .def("writeGnuplot", &writeTrajectoryGnuplot)
+            .def("findFrame", &TrajectoryReader::findFrame)
+            .def("getIteration", &TrajectoryReader::getIteration)
+            .def("getTime", &TrajectoryReader::getTime)
+            .def("getFrameCount", &TrajectoryReader::getFrameCount)
+            .def("getAtomCount", &getTrajectoryAtomCount)
+            .def("getChannels", &getTrajectoryChannels)
+            .def("getDx", &getTrajectoryDx)
+            .def("getDt", &getTrajectoryDt)
+            .def("getMass", &getTrajectoryMass)
+    ;
+
+    //potentials
+    class_<PythonPotential>("Potential", init<boost::python::object, bool>((boost::python::arg("function"), boost::python::arg("vectorized") = false)));
+    class_<Potential, boost::noncopyable, std::shared_ptr<Potential>>("NativePotential", no_init)
+            .def("__call__", &evaluatePotential, (boost::python::arg("x"), boost::python::arg("t") = 0.0))
+            .def("sample", &samplePotentialArray, (boost::python::arg("atomCount"), boost::python::arg("t") = 0.0))
+            .def("isTimeDependent", &Potential::isTimeDependent)
+    ;
+    class_<HarmonicPotential, bases<Potential>, std::shared_ptr<HarmonicPotential>>("HarmonicPotential", init<double, optional<double>>());
+    class_<BoxPotential, bases<Potential>, std::shared_ptr<BoxPotential>>("BoxPotential", init<double, double, double>());
+    class_<StepPotential, bases<Potential>, std::shared_ptr<StepPotential>>("StepPotential", init<double, double>());
+    class_<PeriodicPotential, bases<Potential>, std::shared_ptr<PeriodicPotential>>("PeriodicPotential", init<double, double, optional<double>>());
+    enum_<TabulatedPotential::Interpolation>("Interpolation")
+            .value("Linear", TabulatedPotential::Linear)
+            .value("Cubic", TabulatedPotential::Cubic)
+    ;
+    class_<TabulatedPotential, bases<Potential>, std::shared_ptr<TabulatedPotential>>("TabulatedPotential", init<std::string, optional<TabulatedPotential::Interpolation>>());
+    class_<ExpressionPotential, bases<Potential>, std::shared_ptr<ExpressionPotential>>("ExpressionPotential", init<std::string>())
+            .def("getFormula", &ExpressionPotential::getFormula, return_value_policy<copy_const_reference>())
+    ;
 
     //basic solver
     class_<PythonLinearHamiltonianSolver<std::complex<double>>, bases<HamiltonianSolver<std::complex<double>>>>("LinearHamiltonianSolver", init<PythonSimulation*, boost::python::object>());
-    class_<PythonNonLinearHamiltonianSolver<std::complex<double>>, bases<HamiltonianSolver<std::complex<double>>>>("NonLinearHamiltonianSolver", init<PythonSimulation*, boost::python::object, double>());
+    enum_<NonLinearHamiltonianSolver<std::complex<double>>::NonLinearity>("NonLinearity")
+            .value("Global", NonLinearHamiltonianSolver<std::complex<double>>::Global)
+            .value("Local", NonLinearHamiltonianSolver<std::complex<double>>::Local)
+    ;
+    class_<PythonNonLinearHamiltonianSolver<std::complex<double>>, bases<HamiltonianSolver<std::complex<double>>>>("NonLinearHamiltonianSolver", init<PythonSimulation*, boost::python::object, double, optional<NonLinearHamiltonianSolver<std::complex<double>>::NonLinearity>>());
+    class_<FeedbackPotential<std::complex<double>>, boost::noncopyable, std::shared_ptr<FeedbackPotential<std::complex<double>>>>("FeedbackPotential", no_init);
+    class_<DensityFeedback<std::complex<double>>, bases<FeedbackPotential<std::complex<double>>>, std::shared_ptr<DensityFeedback<std::complex<double>>>>("DensityFeedback", init<double>());
+    class_<NeighbourDifferenceFeedback<std::complex<double>>, bases<FeedbackPotential<std::complex<double>>>, std::shared_ptr<NeighbourDifferenceFeedback<std::complex<double>>>>("NeighbourDifferenceFeedback", init<double>());
+    class_<PythonFeedbackHamiltonianSolver<std::complex<double>>, bases<HamiltonianSolver<std::complex<double>>>>("FeedbackHamiltonianSolver", init<PythonSimulation*, boost::python::object, boost::python::object>())
+            .def("addFeedback", &PythonFeedbackHamiltonianSolver<std::complex<double>>::addFeedback)
+    ;
+    class_<PythonTimeDependentHamiltonianSolver<std::complex<double>>, bases<HamiltonianSolver<std::complex<double>>>>("TimeDependentHamiltonianSolver", init<PythonSimulation*, boost::python::object, optional<double>>())
+            .def("getTime", &PythonTimeDependentHamiltonianSolver<std::complex<double>>::getTime)
+            .def("setTime", &PythonTimeDependentHamiltonianSolver<std::complex<double>>::setTime)
+    ;
 }
 
 ScriptExecutor::ScriptExecutor(Simulation &simulation,
-                           const std::string& scriptFile) {
+                           const std::string& scriptFile,
+                           unsigned int sweep,
+                           const SolverFactory& defaultSolver) {
     namespace python = boost::python;
-    Py_Initialize();
+    // boost python does not support Py_Finalize, so the interpreter lives as long as the process
+    if (!Py_IsInitialized()) {
+        Py_Initialize();
+#if PY_VERSION_HEX < 0x03070000
+        // newer interpreters create the global interpreter lock in Py_Initialize
+        PyEval_InitThreads();
+#endif
+    }
 
     // Set working dir in python
     boost::filesystem::path workingDir = boost::filesystem::absolute(boost::filesystem::path(scriptFile).parent_path()).normalize();
-    PyObject* sysPath = PySys_GetObject("path");
-    PyList_Insert(sysPath, 0, PyString_FromString(workingDir.string().c_str()));
+    python::list sysPath(python::borrowed(PySys_GetObject(const_cast<char*>("path"))));
+    if (!sysPath.count(workingDir.string())) {
+        sysPath.insert(0, workingDir.string());
+    }
 
+    python::dict mainNamespace;
+    std::exception_ptr failure;
     try {
-        python::object main = import("__main__");
-        python::object mainNamespace = main.attr("__dict__");
+        static bool registered = false;
+        if (!registered) {
+            initCrankNicolson();
+            registered = true;
+        }
 
-        PythonSimulation sim(&simulation);
-        initCrankNicolson();
+        python::object builtins(python::borrowed(PyEval_GetBuiltins()));
+        mainNamespace["__builtins__"] = builtins;
+        mainNamespace["__name__"] = "__main__";
+        mainNamespace["__file__"] = scriptFile;
 
-        python::scope scope(main);
-        scope.attr("simulation") = object(ptr(&sim));
-        exec_file(scriptFile.c_str(), mainNamespace, mainNamespace);
+        PythonSimulation sim(&simulation);
+        mainNamespace["simulation"] = object(ptr(&sim));
+        mainNamespace["sweep"] = sweep;
+        builtins["eval"](compileScript(scriptFile), mainNamespace, mainNamespace);
 
+        // a simulation with a potential in its setting file does not need a script which sets the solver
+        if (!sim.getSolver() && defaultSolver) {
+            sim.Simulation::setSolver(defaultSolver());
+        }
         sim.run();
+    } catch (error_already_set&) {
+        // the traceback of the python error, which includes the c++ exceptions translated by boost python
+        PyErr_Print();
+        failure = std::make_exception_ptr(std::runtime_error("the script " + scriptFile + " raised an exception"));
+    } catch (std::exception& e) {
+        std::cerr << scriptFile << ": " << e.what() << std::endl;
+        failure = std::current_exception();
+    } catch (...) {
+        failure = std::current_exception();
+    }
+
+    // release the objects of the script, so its open files get flushed before the next script runs
+    try {
+        mainNamespace.clear();
+        python::import("gc").attr("collect")();
     } catch(...) {
         PyErr_Print();
     }
+
+    // the job scheduler counts the failed simulation
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
 }
 
 ScriptExecutor::~ScriptExecutor() {
-    Py_Finalize();
 }
 
 std::vector<boost::filesystem::path> ScriptExecutor::getScriptFiles(const std::string& dir) {
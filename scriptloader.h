@@ -1,22 +1,34 @@
 #pragma once
 
 #include <string>
+#include <memory>
+#include <functional>
 #include <boost/filesystem.hpp>
 
 #include "simulation.h"
 
 /**
  * @brief The ScriptLoader class load all scripts from a directory and execute them for the given simulation.
+ *        The python interpreter is started by the first executor of a process and is kept alive for all
+ *        following scripts, which run in their own namespace. The compiled scripts are cached, so a parameter
+ *        sweep over the same script gets compiled only once.
  */
 class ScriptExecutor {
 public:
+    typedef std::function<std::shared_ptr<ComplexHamiltonianSolver> ()> SolverFactory;
+
     /**
      * @brief ScriptLoader Load a script from a file and execute it.
      * @param simulation The current simulation.
      * @param scriptDir The directory with the python script inside.
+     * @param sweep The index of the simulation within its parameter sweep, available as "sweep" in the script.
+     * @param defaultSolver Creates the solver of a simulation whose script sets none, may be empty.
+     * @throw std::exception if the script or the simulation failed, after the error has been printed.
      */
     ScriptExecutor(Simulation &simulation,
-                 const std::string& scriptFile);
+                 const std::string& scriptFile,
+                 unsigned int sweep = 0,
+                 const SolverFactory& defaultSolver = SolverFactory());
 
     /**
      * @brief ~ScriptLoader Destructor of the ScriptExecutor
@@ -9,8 +9,11 @@ def hamonicalPotential(x):
 
 outfile = open("harmonicalPotential.dat", "w")
 
+#the potential works on whole numpy arrays, so all atoms get sampled with a single call
+potential = cn.Potential(hamonicalPotential, vectorized=True)
+
 #set the current solver for the crank nicolson algorithm here the non linear hamiltonian solver to solve soliton waves
-simulation.setSolver(cn.LinearHamiltonianSolver(simulation, hamonicalPotential))
+simulation.setSolver(cn.LinearHamiltonianSolver(simulation, potential))
 
 #add a new Gaussian wave to the simulation with the width of 50 at the position 400 and with wavevector length of 50000
 simulation.addWave(cn.GaussianWave(100.0, 500.0, 50000.0))
@@ -21,7 +24,7 @@ simulation.addWave(cn.GaussianWave(20.0, 600.0, -50000.0))
 simulation.addFilter(cn.ProperbilityObservable(outfile))
 
 #add also an observable for the potential only writes ones to stdout at the start of the simulation
-simulation.addFilter(cn.PotentialObservable(outfile, hamonicalPotential)) #sys.stdout
+simulation.addFilter(cn.PotentialObservable(outfile, potential)) #sys.stdout
 
 #write the plot file
 util.plot.writeStaticPlotScript("harmonicalPotential.static.plot", "harmonicalPotential.dat", 1)
@@ -2,11 +2,8 @@ import CrankNicolson as cn
 import utility as util
 import sys
 
-#example potentials
-def potentialWell(x):
-	if (x < 0.300 or x > 0.600):
-        	return 100	
-	return 0.0
+#example potentials, the well gets sampled without calling back into python
+potentialWell = cn.BoxPotential(0.3, 0.6, 100)
 
 outfile = open("PotentialWell.dat", "w")
 
@@ -1,33 +1,134 @@
 #include "simulation.h"
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <limits>
+#include <stdexcept>
+
+#include "observablepipeline.h"
+#include "profiler.h"
 
 Simulation::Simulation(SimulationParameter params, std::shared_ptr<ComplexHamiltonianSolver> ham)
-    : atoms(params.atomCount), hamiltonian(ham), parameter(params), currentIteration(0) {
+    : atoms(params.atomCount), hamiltonian(ham), parameter(params), currentIteration(0), asyncThreads(0), asyncSnapshots(4),
+      relaxIterations(0), relaxInterval(10), relaxTolerance(1e-10), relaxTimeStep(0),
+      relaxedIterations(0), relaxedEnergy(0), relaxedResidual(0) {
+    setThreadCount(params.threads);
 }
 
 Simulation::~Simulation() {
 }
 
 void Simulation::run() {
-    for (auto& it : filter) {
-        if (it->check(Observable::Startup))
-            it->filter(*this);
+    ProfileScope runScope(Profiler::SimulationRun);
+    if (relaxIterations > 0 && relaxedIterations == 0) {
+        relax();
+    }
+    notify(Observable::Startup);
+
+    ComplexHamiltonianSolver::Workspace workspace(atoms.size());
+    workspace.pool = pool.get();
+    std::unique_ptr<ObservablePipeline> pipeline;
+    if (asyncThreads > 0) {
+        pipeline.reset(new ObservablePipeline(*this, Observable::Iteration, asyncThreads, asyncSnapshots));
     }
+    const uint64_t start = Profiler::isEnabled() ? Profiler::now() : 0;
+    {
+        ProfileScope loopScope(Profiler::SimulationLoop);
+        for (unsigned int i = 0; i < parameter.iterations; ++i, ++currentIteration) {
+            {
+                ProfileScope scope(Profiler::SolverStep);
+                hamiltonian->step(atoms, workspace);
+            }
+            {
+                ProfileScope scope(Profiler::Boundary);
+                atoms(0) = atoms(atoms.size() - 1) = 0;
+            }
 
-    for (unsigned int i = 0; i < parameter.iterations; ++i, ++currentIteration) {
-        atoms = hamiltonian->solve(atoms);
+            if (pipeline) {
+                {
+                    ProfileScope scope(Profiler::Publish);
+                    pipeline->publish(*this);
+                }
+                notify(Observable::Iteration, true);
+            } else {
+                notify(Observable::Iteration);
+            }
+        }
+        if (pipeline) {
+            pipeline->finish();
+        }
+    }
+    if (start != 0) {
+        Profiler::get().addSteps(parameter.iterations, Profiler::now() - start);
+    }
+
+    notify(Observable::Cooldown);
+}
+
+void Simulation::setImaginaryTime(unsigned int iterations, double tolerance, double timeStep, unsigned int interval) {
+    if (tolerance < 0 || timeStep < 0) {
+        throw std::invalid_argument("The tolerance and the imaginary time step must not be negative");
+    }
+    relaxIterations = iterations;
+    relaxTolerance = tolerance;
+    relaxTimeStep = timeStep;
+    relaxInterval = interval > 0 ? interval : 1;
+}
+
+bool Simulation::relax() {
+    ProfileScope relaxScope(Profiler::SimulationRelax);
+    const double tau = relaxTimeStep > 0 ? relaxTimeStep : parameter.dt;
+    const double norm = atoms.squaredNorm();
+    if (norm == 0) {
+        throw std::runtime_error("Imaginary time needs a state which is not zero");
+    }
+    if (!hamiltonian->setImaginaryTime(tau / (2 * parameter.mass * parameter.dx * parameter.dx))) {
+        throw std::runtime_error("The solver does not support imaginary time");
+    }
+
+    ComplexHamiltonianSolver::Workspace workspace(atoms.size());
+    ComplexVector product(atoms.size());
+    double previous = std::numeric_limits<double>::quiet_NaN();
+    bool converged = false;
+    relaxedIterations = 0;
+    while (relaxedIterations < relaxIterations && !converged) {
+        {
+            ProfileScope scope(Profiler::SolverStep);
+            hamiltonian->step(atoms, workspace);
+        }
         atoms(0) = atoms(atoms.size() - 1) = 0;
+        ++relaxedIterations;
+
+        // the damping shrinks the state by about exp(-E tau) per step
+        const double current = atoms.squaredNorm();
+        if (!(current > 0) || !std::isfinite(current)) {
+            hamiltonian->setImaginaryTime(0);
+            throw std::runtime_error("The state vanished in imaginary time");
+        }
+        atoms.scale(std::sqrt(norm / current));
 
-        for (auto& it : filter) {
-            if (it->check(Observable::Iteration))
-                it->filter(*this);
+        if (relaxedIterations % relaxInterval == 0 || relaxedIterations == relaxIterations) {
+            hamiltonian->applyHamiltonian(atoms, product);
+            relaxedEnergy = atoms.dot(product).real() / norm;
+            product -= atoms * relaxedEnergy;
+            relaxedResidual = std::sqrt(product.squaredNorm() / norm) / std::max(std::abs(relaxedEnergy), 1e-300);
+            converged = relaxedResidual <= relaxTolerance
+                    || std::abs(relaxedEnergy - previous) <= relaxTolerance * std::abs(relaxedEnergy);
+            previous = relaxedEnergy;
         }
     }
 
+    hamiltonian->setImaginaryTime(0);
+    return converged;
+}
+
+void Simulation::notify(Observable::CheckTime time, bool synchronousOnly) {
     for (auto& it : filter) {
-        if (it->check(Observable::Cooldown))
+        if ((!synchronousOnly || it->isSynchronous()) && it->check(time, currentIteration, parameter.dt)) {
+            ProfileScope scope(typeid(*it), "observable.");
             it->filter(*this);
+        }
     }
 }
 
@@ -43,6 +144,27 @@ void Simulation::setSolver(std::shared_ptr<ComplexHamiltonianSolver> solver) {
     hamiltonian = solver;
 }
 
+void Simulation::setThreadCount(unsigned int threads) {
+    if (threads > 1) {
+        pool = std::make_shared<ThreadPool>(threads);
+    } else {
+        pool.reset();
+    }
+}
+
+unsigned int Simulation::getThreadCount() const {
+    return pool ? pool->getThreadCount() : 1;
+}
+
+void Simulation::setAsyncObservers(unsigned int threads, unsigned int snapshots) {
+    asyncThreads = threads;
+    asyncSnapshots = snapshots > 0 ? snapshots : 1;
+}
+
+Simulation* Simulation::createSnapshot() const {
+    return new Simulation(*this);
+}
+
 void Simulation::addWave(const ComplexWave* wave) {
     for (unsigned int i = 1; i < atoms.size() - 1; ++i) {
         atoms[i] += wave->getDisplacement(i);
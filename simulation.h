@@ -8,6 +8,8 @@
 #include "wave.h"
 #include "observable.h"
 #include "hamiltonian.h"
+#include "threadpool.h"
+#include "potential.h"
 #include "TridiagonalMatrix.h"
 #include "SimulationParameter.h"
 
@@ -32,13 +34,54 @@ public:
      * @param hamiltonian The solver which solves the Schrödinger equation.
      */
     Simulation(SimulationParameter params, std::shared_ptr<ComplexHamiltonianSolver> hamiltonian);
-    ~Simulation();
+    virtual ~Simulation();
 
     /**
      * @brief #run Runs the simulation and call the filter method of the observables.
+     *             If imaginary time steps are set and the state was not relaxed yet,
+     *             it gets relaxed by #relax before the startup observables.
      */
     void run();
 
+    /**
+     * @brief #setImaginaryTime Relax the state in imaginary time \f$ \Delta t = -i\tau \f$ before the real time run.
+     * @param iterations The maximal count of imaginary time steps, zero disables the relaxation.
+     * @param tolerance The relative change of the energy or the relative residual \f$ |H\psi - E\psi| / |E\psi| \f$
+     *                  at which the relaxation stops.
+     * @param timeStep The imaginary time step \f$ \tau \f$, zero uses the time step of the simulation.
+     * @param interval The count of steps between two evaluations of the energy and the residual.
+     */
+    void setImaginaryTime(unsigned int iterations, double tolerance = 1e-10, double timeStep = 0, unsigned int interval = 10);
+
+    /**
+     * @brief #relax Propagate the state by implicit Euler steps in imaginary time, which damp every eigenstate by
+     *               \f$ 1 / (1 + E_n\tau) \f$, until the energy or the residual converges. The state gets renormalized
+     *               to its initial norm after every step, so it converges to the lowest eigenstate which overlaps with
+     *               it, or for a nonlinear solver to a stationary state. The solver factorizes its left matrix once and is in real time afterwards.
+     * @return True if the relaxation converged within the iterations of #setImaginaryTime.
+     * @throw std::runtime_error if the solver does not support imaginary time or the state is zero.
+     */
+    bool relax();
+
+    /**
+     * @brief #getRelaxationIterations Return the count of imaginary time steps of the last relaxation.
+     * @return The iteration count.
+     */
+    unsigned int getRelaxationIterations() const { return relaxedIterations; }
+
+    /**
+     * @brief #getRelaxationEnergy Return the energy \f$ \langle\psi|H|\psi\rangle / \langle\psi|\psi\rangle \f$ of the
+     *                             relaxed state in the units of the hamiltonian matrix.
+     * @return The energy.
+     */
+    double getRelaxationEnergy() const { return relaxedEnergy; }
+
+    /**
+     * @brief #getRelaxationResidual Return the relative residual of the relaxed state.
+     * @return The residual \f$ |H\psi - E\psi| / |E\psi| \f$.
+     */
+    double getRelaxationResidual() const { return relaxedResidual; }
+
     /**
      * @brief #setSolver Sets the current solver of the simulation.
      * @param solver The solver for the Schrödinger equation.
@@ -57,6 +100,34 @@ public:
      */
     void setSolver(std::shared_ptr<ComplexHamiltonianSolver> solver);
 
+    /**
+     * @brief #setThreadCount Sets the count of threads the solver may use for one step.
+     *                        Small systems get solved sequentially regardless of this value.
+     * @param threads The thread count, one disables the parallel solver.
+     */
+    void setThreadCount(unsigned int threads);
+
+    /**
+     * @brief #getThreadCount Return the count of threads the solver may use for one step.
+     * @return The thread count.
+     */
+    unsigned int getThreadCount() const;
+
+    /**
+     * @brief #setAsyncObservers Run the iteration observables on background threads, see ObservablePipeline.
+     *                           The observables get a snapshot of the state, so they must not rely on
+     *                           the solver or other observables being at the same step.
+     * @param threads The count of background threads, zero runs the observables in the simulation loop.
+     * @param snapshots The count of preallocated snapshots, the simulation waits if all of them are in use.
+     */
+    void setAsyncObservers(unsigned int threads, unsigned int snapshots = 4);
+
+    /**
+     * @brief #getAsyncObserverThreads Return the count of background threads for the iteration observables.
+     * @return The thread count, zero if the observables run in the simulation loop.
+     */
+    unsigned int getAsyncObserverThreads() const { return asyncThreads; }
+
     /**
      * @brief #addWave Add a wave to the simulation.
      * @param wave The wave to add.
@@ -75,11 +146,23 @@ public:
      */
     void addFilter(std::shared_ptr<Observable> filter);
 
+    /**
+     * @brief #setPotential Set the native potential of the simulation, e.g. the potential of the setting file.
+     * @param potential The potential or nullptr.
+     */
+    void setPotential(std::shared_ptr<Potential> potential) { this->potential = potential; }
+
+    /**
+     * @brief #getPotential Return the native potential of the simulation.
+     * @return The potential or nullptr if none was set.
+     */
+    std::shared_ptr<Potential> getPotential() const { return potential; }
+
     /**
      * @brief #getParameter Return the current SimulationParameter of the simulation.
      * @return The simulation parameter with timestep and resolution.
      */
-    SimulationParameter getParameter() const { return parameter; }
+    const SimulationParameter& getParameter() const { return parameter; }
 
     /**
      * @brief #getIteration Returns the current iteration index.
@@ -88,14 +171,43 @@ public:
     int getIteration() const { return currentIteration; }
 
     /**
-     * @brief #getAtoms Get the atoms in the current simulation in a vector.
+     * @brief #getAtoms Get the atoms in the current simulation in a vector without copying them.
+     *                  The reference stays valid for the lifetime of the simulation and reflects every step.
      * @return The atoms in the simulation in a vector.
      */
-    ComplexVector getAtoms() const { return atoms; }
+    const ComplexVector& getAtoms() const { return atoms; }
+
+    friend class BatchSimulation;
+    friend class ObservablePipeline;
 protected:
+    /**
+     * @brief #createSnapshot Create a copy of the simulation which holds the state for an asynchronous observable.
+     *                        Derived classes return their own type, so observables may cast the simulation.
+     * @return The new snapshot, owned by the caller.
+     */
+    virtual Simulation* createSnapshot() const;
+
+    /**
+     * @brief #notify Call the filter method of all observables, which filter at the given time.
+     * @param time The current time of the simulation.
+     * @param synchronousOnly True to skip the observables which run in an ObservablePipeline.
+     */
+    void notify(Observable::CheckTime time, bool synchronousOnly = false);
+
     ComplexVector atoms;
     std::shared_ptr<ComplexHamiltonianSolver> hamiltonian;
     std::vector<std::shared_ptr<Observable>> filter;
+    std::shared_ptr<ThreadPool> pool;
+    std::shared_ptr<Potential> potential;
     SimulationParameter parameter;
     int currentIteration;
+    unsigned int asyncThreads;
+    unsigned int asyncSnapshots;
+    unsigned int relaxIterations;  //! The maximal count of imaginary time steps
+    unsigned int relaxInterval;    //! The steps between two convergence checks
+    double relaxTolerance;
+    double relaxTimeStep;          //! The imaginary time step, zero uses dt
+    unsigned int relaxedIterations;
+    double relaxedEnergy;
+    double relaxedResidual;
 };
@@ -1,44 +1,230 @@
 #include "simulationexecutor.h"
 
+#include <cmath>
+#include <limits>
+#include <iostream>
+
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/json_parser.hpp>
 
+#include "jobscheduler.h"
+#include "profiler.h"
 #include "scriptloader.h"
 #include "simulation.h"
 
+#include "linearhamiltonian.h"
 #include "nonlinearhamiltonian.h"
+#include "timedependenthamiltonian.h"
 
 using namespace boost;
 using namespace property_tree;
 
+namespace {
+
+/**
+ * @brief #sweepValues Read the values of a simulation entry, which is a scalar, a list or a range.
+ *                     All parameters of a simulation are positive, the atom, iteration and thread counts are integers.
+ * @param tree The simulation entry.
+ * @param key The name of the parameter.
+ * @param integer True if every value must be an integer, e.g. a range of atom counts must hit integers at every step.
+ * @param fallback The value of a missing optional parameter or nullptr if the parameter is required.
+ * @return All values of the parameter.
+ * @throw ptree_bad_data if a value is not positive or not an integer.
+ */
+std::vector<double> sweepValues(const ptree& tree, const std::string& key, bool integer, const double* fallback = nullptr) {
+    boost::optional<const ptree&> child = tree.get_child_optional(key);
+    if (!child) {
+        if (!fallback) {
+            throw ptree_bad_path("missing simulation parameter", ptree::path_type(key));
+        }
+        return std::vector<double>(1, *fallback);
+    }
+
+    std::vector<double> values;
+    if (child->empty()) {
+        values.push_back(child->get_value<double>());
+    } else if (child->count("from") > 0) {
+        const double from = child->get<double>("from");
+        const double to = child->get<double>("to");
+        const unsigned int steps = child->get<unsigned int>("steps");
+        for (unsigned int i = 0; i < steps; ++i) {
+            values.push_back(steps > 1 ? from + (to - from) * i / (steps - 1) : from);
+        }
+    } else {
+        for (auto it = child->begin(); it != child->end(); ++it) {
+            values.push_back(it->second.get_value<double>());
+        }
+    }
+    if (values.empty()) {
+        throw ptree_bad_data("empty simulation parameter", key);
+    }
+    for (double value : values) {
+        if (!(value > 0)) {
+            throw ptree_bad_data("simulation parameter " + key + " must be positive", key);
+        }
+        if (integer && (value != std::floor(value) || value > std::numeric_limits<unsigned int>::max())) {
+            throw ptree_bad_data("simulation parameter " + key + " must be an integer", key);
+        }
+    }
+    return values;
+}
+
+/**
+ * @brief #loadPotential Create the native potential of a simulation entry.
+ * @param tree The simulation entry.
+ * @return The potential or nullptr if the entry has none.
+ */
+std::shared_ptr<Potential> loadPotential(const ptree& tree) {
+    boost::optional<const ptree&> child = tree.get_child_optional("potential");
+    if (!child) {
+        return nullptr;
+    }
+    if (child->empty()) {
+        return std::make_shared<ExpressionPotential>(child->get_value<std::string>());
+    }
+
+    const std::string type = child->get<std::string>("type");
+    if (type == "harmonic") {
+        return std::make_shared<HarmonicPotential>(child->get<double>("omega"), child->get<double>("center", 0.5));
+    } else if (type == "box") {
+        return std::make_shared<BoxPotential>(child->get<double>("left"), child->get<double>("right"), child->get<double>("height"));
+    } else if (type == "step") {
+        return std::make_shared<StepPotential>(child->get<double>("position"), child->get<double>("height"));
+    } else if (type == "periodic") {
+        return std::make_shared<PeriodicPotential>(child->get<double>("amplitude"), child->get<double>("period"), child->get<double>("phase", 0.0));
+    } else if (type == "tabulated") {
+        const std::string interpolation = child->get<std::string>("interpolation", "linear");
+        if (interpolation != "linear" && interpolation != "cubic") {
+            throw ptree_bad_data("unknown interpolation " + interpolation, interpolation);
+        }
+        return std::make_shared<TabulatedPotential>(child->get<std::string>("file"),
+                                                    interpolation == "cubic" ? TabulatedPotential::Cubic : TabulatedPotential::Linear);
+    } else if (type == "expression") {
+        return std::make_shared<ExpressionPotential>(child->get<std::string>("formula"));
+    }
+    throw ptree_bad_data("unknown potential type " + type, type);
+}
+
+}
+
 SimulationExecutor::SimulationExecutor(const std::string& filename) {
+    load(filename);
+    run();
+}
+
+SimulationExecutor::SimulationExecutor(const SimulationParameter& params, const std::string& scriptFile) {
+    simulations.push_back(Job(params, scriptFile, 0));
+
+    run();
+}
+
+SimulationExecutor::SimulationExecutor(const std::vector<std::string>& filenames, unsigned int jobs) {
+    for (auto filename : filenames) {
+        std::cout << "process file: " << filename << std::endl;
+        try {
+            load(filename);
+        } catch (std::exception& e) {
+            std::cerr << "skip file " << filename << ": " << e.what() << std::endl;
+        }
+    }
+
+    run(jobs);
+}
+
+void SimulationExecutor::load(const std::string& filename) {
     ptree tree;
     json_parser::read_json(filename, tree);
 
     for (auto it = tree.begin(); it != tree.end(); ++it) {
         if (it->first == "Simulation") {
             const ptree& child = it->second;
-            SimulationParameter params(child.get<double>("dx"),
-                                       child.get<double>("dt"),
-                                       child.get<double>("mass"),
-                                       child.get<int>("iterations"),
-                                       child.get<int>("atoms"));
-            simulations.push_back(std::pair<SimulationParameter, std::string>(params, child.get<std::string>("script")));
+            const std::string script = child.get<std::string>("script");
+            const std::shared_ptr<Potential> potential = loadPotential(child);
+            const double defaultThreads = 1;
+            const std::vector<std::vector<double>> values = {
+                sweepValues(child, "dx", false),
+                sweepValues(child, "atoms", true),
+                sweepValues(child, "mass", false),
+                sweepValues(child, "dt", false),
+                sweepValues(child, "iterations", true),
+                sweepValues(child, "threads", true, &defaultThreads)
+            };
+
+            // the last parameter varies fastest, so simulations on the same grid stay next to each other
+            size_t count = 1;
+            for (auto& value : values) {
+                count *= value.size();
+            }
+            for (size_t index = 0; index < count; ++index) {
+                std::vector<double> current(values.size());
+                size_t rest = index;
+                for (size_t k = values.size(); k-- > 0;) {
+                    current[k] = values[k][rest % values[k].size()];
+                    rest /= values[k].size();
+                }
+                SimulationParameter params(current[0],
+                                           current[3],
+                                           current[2],
+                                           static_cast<unsigned int>(current[4]),
+                                           static_cast<unsigned int>(current[1]),
+                                           static_cast<unsigned int>(current[5]));
+                simulations.push_back(Job(params, script, static_cast<unsigned int>(index), potential));
+            }
         }
     }
-
-    run();
 }
 
-SimulationExecutor::SimulationExecutor(const SimulationParameter& params, const std::string& scriptFile) {
-    simulations.push_back(std::pair<SimulationParameter, std::string>(params, scriptFile));
+void SimulationExecutor::run(unsigned int jobs) {
+    // the work of a simulation grows with its grid size and its iterations
+    std::vector<double> costs;
+    for (auto& simul : simulations) {
+        costs.push_back(static_cast<double>(simul.parameter.atomCount) * simul.parameter.iterations);
+    }
 
-    run();
+    JobScheduler scheduler(jobs);
+    const unsigned int failed = scheduler.run(costs, [this](unsigned int index) {
+        // every job gets its own report, so the reports of forked workers do not get lost
+        if (Profiler::isEnabled()) {
+            Profiler::get().reset();
+        }
+        const Job& job = simulations[index];
+        Simulation sim(job.parameter, nullptr);
+        sim.setPotential(job.potential);
+        ScriptExecutor::SolverFactory defaultSolver;
+        if (job.potential) {
+            defaultSolver = [this, &job]() { return createSolver(job); };
+        }
+        ScriptExecutor(sim, job.script, job.sweep, defaultSolver);
+        if (Profiler::isEnabled()) {
+            Profiler::get().save(simulations[index].script, index, static_cast<unsigned int>(simulations.size()));
+        }
+    });
+    if (failed > 0) {
+        std::cerr << failed << " of " << simulations.size() << " simulations failed" << std::endl;
+    }
+}
+
+const std::vector<double>& SimulationExecutor::samplePotential(const Potential& potential, unsigned int atomCount) {
+    // the potentials live as long as the executor, so their address identifies them
+    auto it = samples.find(std::make_pair(&potential, atomCount));
+    if (it == samples.end()) {
+        it = samples.insert(std::make_pair(std::make_pair(&potential, atomCount), potential.sample(atomCount))).first;
+    }
+    return it->second;
 }
 
-void SimulationExecutor::run() {
-    for (std::pair<SimulationParameter, std::string> simul : simulations) {
-        Simulation sim(simul.first, nullptr);
-        ScriptExecutor(sim, simul.second);
+std::shared_ptr<ComplexHamiltonianSolver> SimulationExecutor::createSolver(const Job& job) {
+    typedef std::complex<double> T;
+    const SimulationParameter& parameter = job.parameter;
+    if (job.potential->isTimeDependent()) {
+        return std::make_shared<TimeDependentHamiltonianSolver<T>>(parameter, job.potential);
+    }
+
+    // the jobs are sorted by their cost, so the jobs on the same grid usually follow each other
+    const SolverKey key(job.potential.get(), parameter.atomCount, parameter.dx, parameter.dt, parameter.mass);
+    if (!solver || solverKey != key) {
+        solver = std::make_shared<LinearHamiltonianSolver<T>>(parameter, samplePotential(*job.potential, parameter.atomCount));
+        solverKey = key;
     }
+    return solver;
 }
@@ -1,12 +1,21 @@
 #pragma once
 
+#include <map>
+#include <tuple>
 #include <string>
 #include <vector>
+#include <memory>
 
 #include "SimulationParameter.h"
+#include "potential.h"
+#include "simulation.h"
 
 /**
  * @brief The SimulationExecutor class load a setting file and execute the simulations with its parameter.
+ *        Every numeric entry of a simulation may be a parameter sweep, either a list of values or a range
+ *        of the form {"from": a, "to": b, "steps": n}, which expands into the cartesian product of simulations.
+ *        The optional entry "potential" selects a native potential, either a formula string for an ExpressionPotential
+ *        or an object with a "type" of harmonic, box, step, periodic, tabulated or expression and its parameters.
  */
 class SimulationExecutor
 {
@@ -24,8 +33,48 @@ public:
      */
     SimulationExecutor(const SimulationParameter& params, const std::string& scriptFile);
 
+    /**
+     * @brief SimulationExecutor Loads all given files and execute their simulations on parallel worker processes.
+     * @param filenames The filenames to load the parameter from.
+     * @param jobs The number of simulations which may run at the same time.
+     */
+    SimulationExecutor(const std::vector<std::string>& filenames, unsigned int jobs);
+
 private:
-    void run();
+    /**
+     * @brief The Job struct holds one expanded simulation of a setting file.
+     */
+    struct Job {
+        Job(const SimulationParameter& Parameter, const std::string& Script, unsigned int Sweep,
+            std::shared_ptr<Potential> NativePotential = nullptr)
+            : parameter(Parameter), script(Script), sweep(Sweep), potential(NativePotential) {
+        }
+
+        SimulationParameter parameter;        //! The parameter of the simulation
+        std::string script;                   //! The script to run the simulation with
+        unsigned int sweep;                   //! The index of the simulation within the expanded sweep of its entry
+        std::shared_ptr<Potential> potential; //! The native potential of the entry or nullptr
+    };
+
+    void load(const std::string& filename);
+    void run(unsigned int jobs = 1);
+
+    /**
+     * @brief #samplePotential Sample a time independent potential once per grid, the samples are kept
+     *                         for all following jobs of the process with the same potential and atom count.
+     */
+    const std::vector<double>& samplePotential(const Potential& potential, unsigned int atomCount);
+
+    /**
+     * @brief #createSolver Create the solver of a job whose script sets none. Jobs with the same time independent
+     *                      potential, grid, time step and mass share the factorized solver of the previous job.
+     */
+    std::shared_ptr<ComplexHamiltonianSolver> createSolver(const Job& job);
+
+    typedef std::tuple<const Potential*, unsigned int, double, double, double> SolverKey;
 
-    std::vector<std::pair<SimulationParameter, std::string>> simulations;
+    std::vector<Job> simulations;
+    std::map<std::pair<const Potential*, unsigned int>, std::vector<double>> samples; //! The sampled potentials of the process
+    std::shared_ptr<ComplexHamiltonianSolver> solver; //! The solver of the previous job with a native potential
+    SolverKey solverKey;                              //! The potential, atoms, dx, dt and mass of the solver
 };
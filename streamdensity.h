@@ -23,7 +23,7 @@ public:
      * @param sim The current simulation step.
      */
     virtual void filter(const Simulation& sim) {
-        const ComplexVector atoms = sim.getAtoms();
+        const ComplexVector& atoms = sim.getAtoms();
         const ComplexVector grad = gradient(atoms, sim);
         const double j = 1.0 / sim.getParameter().mass * (atoms.dot(grad)).imag();
         (*stream.get()) << sim.getIteration() << " " << j << "\n";
@@ -32,12 +32,13 @@ public:
 private:
     ComplexVector gradient(const ComplexVector& vec, const Simulation& sim) {
         ComplexVector v(vec.size());
+        const double dx = sim.getParameter().dx;
 
-        v(0) = (vec(1) - vec(0)) / sim.getParameter().dx;
+        v(0) = (vec(1) - vec(0)) / dx;
         for (unsigned int i = 1; i < vec.size() - 1; ++i) {
-            v(i) = (vec(i + 1) - vec(i - 1)) / (2 * sim.getParameter().dx);
+            v(i) = (vec(i + 1) - vec(i - 1)) / (2 * dx);
         }
-        v(vec.size() - 1) = (vec(vec.size() - 1) - vec(vec.size() - 2)) / sim.getParameter().dx;
+        v(vec.size() - 1) = (vec(vec.size() - 1) - vec(vec.size() - 2)) / dx;
 
         return v;
     }
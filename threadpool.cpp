@@ -0,0 +1,60 @@
+#include "threadpool.h"
+
+ThreadPool::ThreadPool(unsigned int Threads)
+    : function(nullptr), context(nullptr), generation(0), pending(0), threadCount(Threads > 0 ? Threads : 1), stop(false) {
+    for (unsigned int i = 1; i < threadCount; ++i) {
+        workers.push_back(std::thread(&ThreadPool::work, this, i));
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+    }
+    start.notify_all();
+    for (auto& it : workers) {
+        it.join();
+    }
+}
+
+void ThreadPool::dispatch(Function f, const void* c) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        function = f;
+        context = c;
+        pending = threadCount - 1;
+        ++generation;
+    }
+    start.notify_all();
+
+    f(c, 0);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [this] { return pending == 0; });
+}
+
+void ThreadPool::work(unsigned int index) {
+    unsigned long seen = 0;
+    while (true) {
+        Function currentFunction;
+        const void* currentContext;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            start.wait(lock, [&] { return stop || generation != seen; });
+            if (stop) {
+                return;
+            }
+            seen = generation;
+            currentFunction = function;
+            currentContext = context;
+        }
+
+        currentFunction(currentContext, index);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--pending == 0) {
+            done.notify_one();
+        }
+    }
+}
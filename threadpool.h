@@ -0,0 +1,68 @@
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+/**
+ * @brief The ThreadPool class keeps a fixed number of worker threads alive to run fork join tasks.
+ *        Every call of #run executes the task once per thread with the thread index and returns
+ *        after all threads finished. The calling thread works as the thread with index zero, so
+ *        a pool with a single thread does not start any worker.
+ */
+class ThreadPool
+{
+public:
+    /**
+     * @brief ThreadPool Start the worker threads.
+     * @param Threads The number of threads including the calling thread.
+     */
+    ThreadPool(unsigned int Threads);
+
+    /**
+     * @brief ~ThreadPool Stop and join all worker threads.
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator = (const ThreadPool&) = delete;
+
+    /**
+     * @brief #run Execute the task on all threads and wait for them.
+     *             The task is passed without a copy, so this does not allocate.
+     * @param task The callable which gets called with the index of the thread in [0, getThreadCount()).
+     */
+    template <typename Task>
+    void run(const Task& task) {
+        dispatch(&invoke<Task>, &task);
+    }
+
+    /**
+     * @brief #getThreadCount Return the number of threads including the calling thread.
+     * @return The number of threads.
+     */
+    unsigned int getThreadCount() const { return threadCount; }
+
+private:
+    typedef void (*Function)(const void*, unsigned int);
+
+    template <typename Task>
+    static void invoke(const void* task, unsigned int index) {
+        (*static_cast<const Task*>(task))(index);
+    }
+
+    void dispatch(Function function, const void* context);
+    void work(unsigned int index);
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable start;
+    std::condition_variable done;
+    Function function;
+    const void* context;
+    unsigned long generation;
+    unsigned int pending;
+    unsigned int threadCount;
+    bool stop;
+};
@@ -0,0 +1 @@
+#include "timedependenthamiltonian.h"
@@ -0,0 +1,198 @@
+#pragma once
+
+#include <assert.h>
+#include <complex>
+#include <memory>
+#include <vector>
+#include "hamiltonian.h"
+#include "potential.h"
+#include "StencilHamiltonian.h"
+#include "StencilPropagator.h"
+#include "PartitionedTridiagonalFactorization.h"
+#include "profiler.h"
+#include "SimulationParameter.h"
+
+/**
+ * @brief TimeDependentHamiltonianSolver Linear Schrödinger equation solver for a driven potential \f$ V(r, t) \f$.
+ * The step from \f$ t \f$ to \f$ t + \Delta t \f$ uses the hamiltonian at the midpoint time
+ * \f[
+ *      (1 + \frac{i\Delta t}{2} H(t + \frac{\Delta t}{2}))|x(r,t)\rangle^{n+1} = (1 - \frac{i\Delta t}{2} H(t + \frac{\Delta t}{2}))|x(r,t)\rangle^{n}
+ * \f]
+ * which keeps the second order of the Crank Nicolson method. Only the main diagonal of the hamiltonian
+ * depends on the time, so every step samples the potential once, rewrites the diagonal of the
+ * StencilHamiltonian and factorizes within the forward substitution. The constant off diagonals
+ * never get touched. A potential which does not depend on the time gets factorized only once.
+ */
+template <typename T>
+class TimeDependentHamiltonianSolver : public HamiltonianSolver<T>
+{
+public:
+    /**
+     * @brief TimeDependentHamiltonianSolver construct the solver from the SimulationParamter and a potential.
+     * @param Parameter The Parameter with time step and resolution.
+     * @param NativePotential The potential \f$ V(x, t) \f$ for the positions \f$ x \in [0, 1] \f$.
+     * @param StartTime The simulation time of the first step.
+     */
+    TimeDependentHamiltonianSolver(SimulationParameter Parameter,
+                                   std::shared_ptr<Potential> NativePotential,
+                                   double StartTime = 0)
+        : parameter(Parameter), potential(NativePotential), time(StartTime), sampledTime(0), sampled(false) {
+        assert(potential);
+        hamiltonian = StencilHamiltonian<T>(parameter.atomCount, -1.0);
+        samples.resize(parameter.atomCount);
+        updateDiagonal(time + parameter.dt / 2);
+        propagator.factorize(hamiltonian, parameter.lambda);
+    }
+
+    /**
+     * @brief #solve Solve the equation for the wave function and advance the time.
+     * @param current The current wave vector of the simulation.
+     * @return The new wave in the next timestep of the simulation.
+     */
+    virtual Vector<T> solve(const Vector<T>& current) override {
+        Vector<T> next(current);
+        propagate(next);
+        return next;
+    }
+
+    /**
+     * @brief #step Propagate the wave function one timestep inplace without any allocation and advance the time.
+     *              Large systems get partitioned over the threads of the workspace.
+     * @param state The current wave vector of the simulation, which gets replaced by the next timestep.
+     * @param workspace The preallocated buffers for the step.
+     */
+    virtual void step(Vector<T>& state, typename HamiltonianSolver<T>::Workspace& workspace) override {
+        if (workspace.pool && PartitionedTridiagonalFactorization<T>::isSuitable(state.size(), workspace.pool->getThreadCount())) {
+            const bool changed = updateDiagonal(time + parameter.dt / 2);
+            if (left.getSize() != hamiltonian.getSize()) {
+                ProfileScope scope(Profiler::SolverAssemble);
+                hamiltonian.toCrankNicolson(left, parameter.lambda, 1.0);
+                hamiltonian.toCrankNicolson(right, parameter.lambda, -1.0);
+            } else if (changed) {
+                ProfileScope scope(Profiler::SolverAssemble);
+                hamiltonian.updateCrankNicolsonDiagonal(left, parameter.lambda, 1.0);
+                hamiltonian.updateCrankNicolsonDiagonal(right, parameter.lambda, -1.0);
+            }
+            if (changed || partition.getBlockCount() != workspace.pool->getThreadCount()) {
+                ProfileScope scope(Profiler::SolverFactorize);
+                partition.factorize(left, *workspace.pool);
+            }
+            {
+                ProfileScope scope(Profiler::SolverPropagate);
+                partition.propagate(right, state, *workspace.pool);
+            }
+            time += parameter.dt;
+        } else {
+            propagate(state);
+        }
+    }
+
+    /**
+     * @brief #step Propagate all states of a batch one timestep inplace, the members share the time and the factorization.
+     * @param states The current wave vectors, which get replaced by the next timestep.
+     * @param workspace The preallocated buffers for the step.
+     */
+    virtual void step(VectorBatch<T>& states, typename HamiltonianSolver<T>::Workspace& workspace) override {
+        if (updateDiagonal(time + parameter.dt / 2)) {
+            ProfileScope scope(Profiler::SolverFactorize);
+            propagator.factorize(hamiltonian, parameter.lambda);
+        }
+        {
+            ProfileScope scope(Profiler::SolverPropagate);
+            propagator.propagate(hamiltonian, states, workspace.row);
+        }
+        time += parameter.dt;
+    }
+
+    /**
+     * @brief #getTime Return the simulation time of the next step.
+     * @return The time \f$ t \f$ of the current state.
+     */
+    double getTime() const { return time; }
+
+    /**
+     * @brief #setTime Set the simulation time of the next step, e.g. to restart a pulse.
+     * @param Time The time \f$ t \f$ of the current state.
+     */
+    void setTime(double Time) { time = Time; }
+
+    /**
+     * @brief #getHamiltonianMatrix Return the hamilton matrix of the last step.
+     * @return The Hamilton matrix.
+     */
+    virtual TridiagonalMatrix<T> getHamiltonianMatrix() override {
+        return hamiltonian.toMatrix();
+    }
+
+    /**
+     * @brief #getLeftMatrix The left assigned matrix of the last step.
+     * @return The left assigned matrix.
+     */
+    virtual TridiagonalMatrix<T> getLeftMatrix() override {
+        TridiagonalMatrix<T> mat;
+        hamiltonian.toCrankNicolson(mat, parameter.lambda, 1.0);
+        return mat;
+    }
+
+    /**
+     * @brief #getRightMatrix The right assigned matrix of the last step.
+     * @return The right assigned matrix.
+     */
+    virtual TridiagonalMatrix<T> getRightMatrix() override {
+        TridiagonalMatrix<T> mat;
+        hamiltonian.toCrankNicolson(mat, parameter.lambda, -1.0);
+        return mat;
+    }
+
+private:
+    /**
+     * @brief #propagate Propagate a state one timestep with the sequential fused factorization and advance the time.
+     * @param state The state to propagate inplace.
+     */
+    void propagate(Vector<T>& state) {
+        const bool changed = updateDiagonal(time + parameter.dt / 2);
+        {
+            ProfileScope scope(Profiler::SolverPropagate);
+            if (changed) {
+                propagator.factorizeAndPropagate(hamiltonian, parameter.lambda, state);
+            } else {
+                propagator.propagate(hamiltonian, state);
+            }
+        }
+        time += parameter.dt;
+    }
+
+    /**
+     * @brief #updateDiagonal Sample the potential at the given time and rewrite the diagonal of the hamiltonian.
+     * @param t The time to sample the potential at.
+     * @return True if the diagonal changed since the last call.
+     */
+    bool updateDiagonal(double t) {
+        if (sampled && (!potential->isTimeDependent() || t == sampledTime)) {
+            return false;
+        }
+        {
+            ProfileScope scope(Profiler::SolverPotential);
+            potential->sample(samples.data(), parameter.atomCount, t);
+        }
+        ProfileScope scope(Profiler::SolverAssemble);
+        for (unsigned int i = 0; i < parameter.atomCount; ++i) {
+            hamiltonian(i) = 2.0 + 2.0 * samples[i];
+        }
+        sampledTime = t;
+        sampled = true;
+        return true;
+    }
+
+    StencilHamiltonian<T> hamiltonian;
+    StencilPropagator<T> propagator;
+    TridiagonalMatrix<T> left;  //! Only built for the partitioned solve
+    TridiagonalMatrix<T> right; //! Only built for the partitioned solve
+    PartitionedTridiagonalFactorization<T> partition;
+    SimulationParameter parameter;
+    std::shared_ptr<Potential> potential;
+    std::vector<double> samples;
+    double time;
+    double sampledTime;
+    bool sampled;
+};
@@ -0,0 +1,171 @@
+#include "trajectory.h"
+
+#include <assert.h>
+#include <cstring>
+#include <stdexcept>
+#include <algorithm>
+
+#include "profiler.h"
+
+namespace {
+const Trajectory::Channel channelOrder[] = { Trajectory::Amplitude, Trajectory::Real, Trajectory::Imaginary };
+const char signature[8] = { 'C', 'N', 'T', 'R', 'A', 'J', 0, 0 };
+const size_t FrameHead = sizeof(uint64_t) + sizeof(double);
+}
+
+unsigned int Trajectory::channelCount(uint32_t channels) {
+    unsigned int count = 0;
+    for (auto channel : channelOrder) {
+        count += (channels & channel) ? 1 : 0;
+    }
+    return count;
+}
+
+uint64_t Trajectory::frameSize(uint32_t atomCount, uint32_t channels) {
+    return FrameHead + sizeof(double) * static_cast<uint64_t>(atomCount) * channelCount(channels);
+}
+
+TrajectoryWriter::TrajectoryWriter(const std::string& filename, const SimulationParameter& parameter, uint32_t channels)
+    : buffer(1 << 20) {
+    file.rdbuf()->pubsetbuf(buffer.data(), buffer.size());
+    file.open(filename.c_str(), std::ios::binary | std::ios::trunc);
+    if (!file) {
+        throw std::runtime_error("could not create trajectory " + filename);
+    }
+
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, signature, sizeof(signature));
+    header.version = Trajectory::Version;
+    header.byteOrder = Trajectory::ByteOrder;
+    header.atomCount = parameter.atomCount;
+    header.channels = channels & (Trajectory::Amplitude | Trajectory::Real | Trajectory::Imaginary);
+    header.dx = parameter.dx;
+    header.dt = parameter.dt;
+    header.mass = parameter.mass;
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    frame.resize(static_cast<size_t>(parameter.atomCount) * Trajectory::channelCount(header.channels));
+}
+
+TrajectoryWriter::~TrajectoryWriter() {
+    close();
+}
+
+void TrajectoryWriter::write(uint64_t iteration, const Vector<std::complex<double>>& atoms) {
+    if (!file.is_open()) {
+        return;
+    }
+    assert(atoms.size() == header.atomCount);
+
+    double* it = frame.data();
+    for (auto channel : channelOrder) {
+        if (!(header.channels & channel)) {
+            continue;
+        }
+        for (unsigned int i = 0; i < header.atomCount; ++i, ++it) {
+            switch (channel) {
+            case Trajectory::Amplitude: *it = std::abs(atoms[i]); break;
+            case Trajectory::Real:      *it = atoms[i].real(); break;
+            case Trajectory::Imaginary: *it = atoms[i].imag(); break;
+            }
+        }
+    }
+
+    const double time = header.dt * iteration;
+    ProfileScope scope(Profiler::TrajectoryWrite);
+    file.write(reinterpret_cast<const char*>(&iteration), sizeof(iteration));
+    file.write(reinterpret_cast<const char*>(&time), sizeof(time));
+    file.write(reinterpret_cast<const char*>(frame.data()), frame.size() * sizeof(double));
+    scope.addBytes(sizeof(iteration) + sizeof(time) + frame.size() * sizeof(double));
+    index.push_back(iteration);
+}
+
+void TrajectoryWriter::close() {
+    if (!file.is_open()) {
+        return;
+    }
+    header.frameCount = index.size();
+    header.indexOffset = Trajectory::HeaderSize + header.frameCount * Trajectory::frameSize(header.atomCount, header.channels);
+    file.write(reinterpret_cast<const char*>(index.data()), index.size() * sizeof(uint64_t));
+    file.seekp(0);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.close();
+}
+
+TrajectoryReader::TrajectoryReader(const std::string& filename)
+    : file(filename.c_str(), std::ios::binary) {
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+            std::memcmp(header.magic, signature, sizeof(signature)) != 0) {
+        throw std::runtime_error("no trajectory file " + filename);
+    }
+    if (header.byteOrder != Trajectory::ByteOrder || header.version != Trajectory::Version) {
+        throw std::runtime_error("unsupported byte order or version of trajectory " + filename);
+    }
+
+    const uint64_t frameSize = Trajectory::frameSize(header.atomCount, header.channels);
+    if (header.indexOffset != 0) {
+        index.resize(header.frameCount);
+        file.seekg(header.indexOffset);
+        file.read(reinterpret_cast<char*>(index.data()), index.size() * sizeof(uint64_t));
+    } else {
+        // the writer did not close the file, recover the index from the complete frames
+        file.seekg(0, std::ios::end);
+        const uint64_t frames = (static_cast<uint64_t>(file.tellg()) - Trajectory::HeaderSize) / frameSize;
+        index.resize(frames);
+        for (uint64_t k = 0; k < frames; ++k) {
+            file.seekg(Trajectory::HeaderSize + k * frameSize);
+            file.read(reinterpret_cast<char*>(&index[k]), sizeof(uint64_t));
+        }
+    }
+    if (!file) {
+        throw std::runtime_error("truncated trajectory " + filename);
+    }
+}
+
+void TrajectoryReader::readFrame(uint64_t frame, Trajectory::Channel channel, std::vector<double>& values) {
+    values.resize(header.atomCount);
+    readFrame(frame, channel, values.data());
+}
+
+void TrajectoryReader::readFrame(uint64_t frame, Trajectory::Channel channel, double* values) {
+    if (frame >= getFrameCount() || !(header.channels & channel)) {
+        throw std::out_of_range("frame or channel not in trajectory");
+    }
+    unsigned int block = 0;
+    for (auto it : channelOrder) {
+        if (it == channel) {
+            break;
+        }
+        block += (header.channels & it) ? 1 : 0;
+    }
+
+    file.seekg(Trajectory::HeaderSize + frame * Trajectory::frameSize(header.atomCount, header.channels) +
+               FrameHead + sizeof(double) * static_cast<uint64_t>(header.atomCount) * block);
+    file.read(reinterpret_cast<char*>(values), header.atomCount * sizeof(double));
+}
+
+std::vector<double> TrajectoryReader::readFrame(uint64_t frame, Trajectory::Channel channel) {
+    std::vector<double> values;
+    readFrame(frame, channel, values);
+    return values;
+}
+
+uint64_t TrajectoryReader::findFrame(uint64_t iteration) const {
+    // the iterations are written in increasing order
+    auto it = std::lower_bound(index.begin(), index.end(), iteration);
+    return (it != index.end() && *it == iteration) ? it - index.begin() : index.size();
+}
+
+void TrajectoryReader::writeGnuplot(std::ostream& output, Trajectory::Channel channel) {
+    std::vector<double> values;
+    for (uint64_t frame = 0; frame < getFrameCount(); ++frame) {
+        readFrame(frame, channel, values);
+        for (unsigned int i = 0; i < values.size(); ++i) {
+            output << static_cast<double>(i) / values.size()
+                   << " "
+                   << values[i]
+                   << "\n";
+        }
+        output << "\n";
+    }
+}
@@ -0,0 +1,199 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <complex>
+#include <cstdint>
+
+#include "Vector.h"
+#include "SimulationParameter.h"
+
+/**
+ * @brief The Trajectory struct describes the binary trajectory format, which stores the wave
+ *        of a simulation for many iterations. The file starts with a header of fixed size,
+ *        followed by frames of fixed size and an index with the iteration of every frame:
+ *
+ *        | Header | Frame 0 | Frame 1 | ... | Frame n-1 | Index |
+ *
+ *        Every frame holds its iteration, its simulation time and one block of doubles per channel,
+ *        so frame k starts at HeaderSize + k * frameSize and can be read without reading the others.
+ *        All values are stored in the byte order of the writing machine, which gets checked by the reader.
+ */
+struct Trajectory {
+    /**
+     * @brief The Channel enum selects the values of the wave which get stored in every frame.
+     */
+    enum Channel {
+        Amplitude = (1 << 0), //! The absolute value \f$ |x_i| \f$ as written by the ProperbilityOberservable.
+        Real      = (1 << 1), //! The real part as written by the RealProperbilityOberservable.
+        Imaginary = (1 << 2)  //! The imaginary part as written by the ImaginaryProperbilityOberservable.
+    };
+
+    /**
+     * @brief The Header struct is the first block of a trajectory file.
+     */
+    struct Header {
+        char magic[8];          //! The file signature "CNTRAJ"
+        uint32_t version;       //! The version of the format
+        uint32_t byteOrder;     //! The value ByteOrder in the byte order of the file
+        uint32_t atomCount;     //! The atom count of the simulation
+        uint32_t channels;      //! The stored channels as a combination of Channel flags
+        double dx;              //! The delta space of the simulation
+        double dt;              //! The delta time of the simulation
+        double mass;            //! The mass of the simulation
+        uint64_t frameCount;    //! The number of frames, which gets written when the file gets closed
+        uint64_t indexOffset;   //! The position of the index, which gets written when the file gets closed
+    };
+
+    static const uint32_t Version = 1;
+    static const uint32_t ByteOrder = 0x01020304;
+    static const uint64_t HeaderSize = sizeof(Header);
+
+    /**
+     * @brief #channelCount Return the number of channels in a combination of flags.
+     * @param channels The combination of Channel flags.
+     * @return The number of channels.
+     */
+    static unsigned int channelCount(uint32_t channels);
+
+    /**
+     * @brief #frameSize Return the size of one frame in bytes.
+     * @param atomCount The atom count of the simulation.
+     * @param channels The combination of Channel flags.
+     * @return The size of one frame.
+     */
+    static uint64_t frameSize(uint32_t atomCount, uint32_t channels);
+};
+
+/**
+ * @brief The TrajectoryWriter class writes the frames of a simulation into a binary trajectory file.
+ */
+class TrajectoryWriter
+{
+public:
+    /**
+     * @brief TrajectoryWriter Create a new trajectory file and write its header.
+     * @param filename The file to create.
+     * @param parameter The parameter of the simulation.
+     * @param channels The combination of Channel flags to store in every frame.
+     * @throw std::runtime_error if the file can not be created.
+     */
+    TrajectoryWriter(const std::string& filename, const SimulationParameter& parameter, uint32_t channels);
+
+    /**
+     * @brief ~TrajectoryWriter Close the file.
+     */
+    ~TrajectoryWriter();
+
+    TrajectoryWriter(const TrajectoryWriter&) = delete;
+    TrajectoryWriter& operator = (const TrajectoryWriter&) = delete;
+
+    /**
+     * @brief #write Append a frame to the file.
+     * @param iteration The iteration of the wave.
+     * @param atoms The wave of the simulation.
+     * @require The wave must have the atom count of the header.
+     */
+    void write(uint64_t iteration, const Vector<std::complex<double>>& atoms);
+
+    /**
+     * @brief #close Write the index and the final header. Further frames are ignored.
+     */
+    void close();
+
+private:
+    std::ofstream file;
+    std::vector<char> buffer;
+    std::vector<uint64_t> index;
+    std::vector<double> frame;
+    Trajectory::Header header;
+};
+
+/**
+ * @brief The TrajectoryReader class reads single frames of a binary trajectory file.
+ *        A file which was not closed, e.g. after a crash, can still be read up to its last complete frame.
+ */
+class TrajectoryReader
+{
+public:
+    /**
+     * @brief TrajectoryReader Open a trajectory file and read its header and index.
+     * @param filename The file to open.
+     * @throw std::runtime_error if the file can not be opened or is no trajectory of this machine.
+     */
+    TrajectoryReader(const std::string& filename);
+
+    /**
+     * @brief #readFrame Read the values of one channel of a frame.
+     * @param frame The index of the frame.
+     * @param channel The channel to read.
+     * @param values The vector to write the atomCount values into.
+     * @throw std::out_of_range if the frame or the channel are not stored in the file.
+     */
+    void readFrame(uint64_t frame, Trajectory::Channel channel, std::vector<double>& values);
+
+    /**
+     * @brief #readFrame Read the values of one channel of a frame into a preallocated buffer.
+     * @param frame The index of the frame.
+     * @param channel The channel to read.
+     * @param values The buffer to write the atomCount values into.
+     * @throw std::out_of_range if the frame or the channel are not stored in the file.
+     */
+    void readFrame(uint64_t frame, Trajectory::Channel channel, double* values);
+
+    /**
+     * @brief #readFrame Read the values of one channel of a frame.
+     * @param frame The index of the frame.
+     * @param channel The channel to read.
+     * @return The atomCount values of the channel.
+     * @throw std::out_of_range if the frame or the channel are not stored in the file.
+     */
+    std::vector<double> readFrame(uint64_t frame, Trajectory::Channel channel);
+
+    /**
+     * @brief #findFrame Return the frame of an iteration.
+     * @param iteration The iteration to search.
+     * @return The index of the frame or getFrameCount() if the iteration was not stored.
+     */
+    uint64_t findFrame(uint64_t iteration) const;
+
+    /**
+     * @brief #writeGnuplot Write one channel of all frames in the text layout of the properbility observables,
+     *                      a line "x value" per atom and an empty line after every frame.
+     * @param output The stream to write the text into.
+     * @param channel The channel to write.
+     */
+    void writeGnuplot(std::ostream& output, Trajectory::Channel channel);
+
+    /**
+     * @brief #getIteration Return the iteration of a frame.
+     * @param frame The index of the frame.
+     * @return The iteration of the frame.
+     */
+    uint64_t getIteration(uint64_t frame) const { return index.at(frame); }
+
+    /**
+     * @brief #getTime Return the simulation time of a frame.
+     * @param frame The index of the frame.
+     * @return The time of the frame.
+     */
+    double getTime(uint64_t frame) const { return header.dt * index.at(frame); }
+
+    /**
+     * @brief #getFrameCount Return the number of frames in the file.
+     * @return The number of frames.
+     */
+    uint64_t getFrameCount() const { return index.size(); }
+
+    /**
+     * @brief #getHeader Return the header of the file.
+     * @return The header with the grid and the time step.
+     */
+    const Trajectory::Header& getHeader() const { return header; }
+
+private:
+    std::ifstream file;
+    std::vector<uint64_t> index;
+    Trajectory::Header header;
+};
@@ -0,0 +1 @@
+#include "trajectoryobservable.h"
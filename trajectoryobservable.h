@@ -0,0 +1,51 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "observable.h"
+#include "simulation.h"
+#include "trajectory.h"
+
+/**
+ * @brief The TrajectoryObservable class is an observable, which writes the wave function of every step
+ *        into a binary trajectory file. The file holds the same values as the properbility observables,
+ *        but needs no text formatting and allows to seek to any frame.
+ */
+class TrajectoryObservable : public Observable
+{
+public:
+    /**
+     * @brief TrajectoryObservable Construct a new observable to write the wave into a trajectory.
+     * @param Filename The trajectory file, which gets created at the first step of the simulation.
+     * @param Channels The combination of Trajectory::Channel flags to store in every frame.
+     */
+    TrajectoryObservable(const std::string& Filename, unsigned int Channels = Trajectory::Amplitude)
+        : Observable(Observable::Iteration), filename(Filename), channels(Channels) {
+    }
+
+    /**
+     * @brief #filter Append the wave of the current step to the trajectory.
+     * @param sim The current simulation step.
+     */
+    virtual void filter(const Simulation& sim) {
+        if (!writer) {
+            writer.reset(new TrajectoryWriter(filename, sim.getParameter(), channels));
+        }
+        writer->write(sim.getIteration(), sim.getAtoms());
+    }
+
+    /**
+     * @brief #close Write the index of the trajectory and close the file.
+     */
+    void close() {
+        if (writer) {
+            writer->close();
+        }
+    }
+
+private:
+    std::string filename;
+    unsigned int channels;
+    std::unique_ptr<TrajectoryWriter> writer;
+};
@@ -0,0 +1,353 @@
+#include "tridiagonaleigensolver.h"
+
+#include <assert.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <stdexcept>
+
+#include "TridiagonalFactorization.h"
+
+namespace {
+/**
+ * The bisection needs a few dozen Sturm counts per eigenvalue, while the QL iterations need about two sweeps,
+ * so on a single thread the whole spectrum gets cheaper when more than this fraction of it is requested.
+ */
+const unsigned int BisectionShare = 10;
+const unsigned int MaximumQLIterations = 60;
+const unsigned int InverseIterations = 3;
+const unsigned int MaximumShiftAttempts = 8;
+/**
+ * Inverse iteration loses orthogonality like the precision of the eigenvalue over its gap, so only eigenvalues
+ * closer than this share of the spectral width get orthogonalized against each other.
+ */
+const double ClusterGap = 1e-6;
+}
+
+const unsigned int TridiagonalEigensolver::Lanes;
+
+TridiagonalEigensolver::TridiagonalEigensolver(const std::vector<double>& Diagonal, const std::vector<double>& OffDiagonal)
+    : diagonal(Diagonal), offDiagonal(Diagonal.size(), 0.0), squares(Diagonal.size(), 0.0) {
+    const unsigned int size = getSize();
+    assert(size > 0 && OffDiagonal.size() + 1 >= size);
+
+    double largestSquare = 1;
+    for (unsigned int i = 0; i + 1 < size; ++i) {
+        offDiagonal[i] = OffDiagonal[i];
+        squares[i] = OffDiagonal[i] * OffDiagonal[i];
+        largestSquare = std::max(largestSquare, squares[i]);
+    }
+    pivot = std::numeric_limits<double>::min() * largestSquare;
+
+    lowerBound = diagonal[0] - std::abs(offDiagonal[0]);
+    upperBound = diagonal[0] + std::abs(offDiagonal[0]);
+    for (unsigned int i = 1; i < size; ++i) {
+        const double radius = std::abs(offDiagonal[i - 1]) + std::abs(offDiagonal[i]);
+        lowerBound = std::min(lowerBound, diagonal[i] - radius);
+        upperBound = std::max(upperBound, diagonal[i] + radius);
+    }
+    const double norm = std::max(std::abs(lowerBound), std::abs(upperBound));
+    tolerance = 2 * std::numeric_limits<double>::epsilon() * norm;
+    lowerBound -= 2 * tolerance + pivot;
+    upperBound += 2 * tolerance + pivot;
+}
+
+unsigned int TridiagonalEigensolver::count(double energy) const {
+    const unsigned int size = getSize();
+    unsigned int negative = 0;
+    double q = diagonal[0] - energy;
+    for (unsigned int i = 1;; ++i) {
+        // a vanishing pivot gets replaced by a tiny negative one, which keeps the count exact
+        if (std::abs(q) < pivot) {
+            q = -pivot;
+        }
+        negative += q < 0;
+        if (i == size) {
+            break;
+        }
+        q = diagonal[i] - energy - squares[i - 1] / q;
+    }
+    return negative;
+}
+
+std::pair<unsigned int, unsigned int> TridiagonalEigensolver::window(double lower, double upper) const {
+    const unsigned int first = lower > lowerBound ? count(lower) : 0;
+    const unsigned int last = upper < upperBound ? count(upper) : getSize();
+    return std::make_pair(first, std::max(first, last));
+}
+
+double TridiagonalEigensolver::eigenvalue(unsigned int index) const {
+    assert(index < getSize());
+    double value;
+    bisect(index, index + 1, &value);
+    return value;
+}
+
+void TridiagonalEigensolver::count(const double* energies, unsigned int* counts) const {
+    const unsigned int size = getSize();
+    double q[Lanes];
+    for (unsigned int j = 0; j < Lanes; ++j) {
+        q[j] = diagonal[0] - energies[j];
+        counts[j] = 0;
+    }
+    // the recurrences of the lanes are independent, so their divisions overlap
+    for (unsigned int i = 1;; ++i) {
+        for (unsigned int j = 0; j < Lanes; ++j) {
+            q[j] = std::abs(q[j]) < pivot ? -pivot : q[j];
+            counts[j] += q[j] < 0;
+        }
+        if (i == size) {
+            break;
+        }
+        const double d = diagonal[i];
+        const double square = squares[i - 1];
+        for (unsigned int j = 0; j < Lanes; ++j) {
+            q[j] = d - energies[j] - square / q[j];
+        }
+    }
+}
+
+void TridiagonalEigensolver::bisect(unsigned int first, unsigned int last, double* result) const {
+    double groupLower = lowerBound;
+    for (unsigned int start = first; start < last; start += Lanes) {
+        const unsigned int length = std::min(Lanes, last - start);
+        double lower[Lanes];
+        double upper[Lanes];
+        double middle[Lanes];
+        unsigned int counts[Lanes];
+        std::fill(lower, lower + Lanes, groupLower);
+        std::fill(upper, upper + Lanes, upperBound);
+        double nextLower = groupLower;
+
+        // every count brackets all eigenvalues of the group and the lowest one of the next group
+        while (true) {
+            // the eigenvalues which still share a bracket get the lanes of the pass split between them
+            double bracketLower[Lanes];
+            double bracketUpper[Lanes];
+            unsigned int brackets = 0;
+            for (unsigned int k = 0; k < length; ++k) {
+                const double center = 0.5 * (lower[k] + upper[k]);
+                if (upper[k] - lower[k] <= tolerance || center <= lower[k] || center >= upper[k]) {
+                    continue;
+                }
+                if (brackets == 0 || lower[k] != bracketLower[brackets - 1] || upper[k] != bracketUpper[brackets - 1]) {
+                    bracketLower[brackets] = lower[k];
+                    bracketUpper[brackets] = upper[k];
+                    ++brackets;
+                }
+            }
+            if (brackets == 0) {
+                break;
+            }
+            for (unsigned int j = 0; j < Lanes; ++j) {
+                const unsigned int bracket = j % brackets;
+                const unsigned int sections = Lanes / brackets + (bracket < Lanes % brackets ? 1 : 0) + 1;
+                const unsigned int section = j / brackets + 1;
+                middle[j] = bracketLower[bracket] + (bracketUpper[bracket] - bracketLower[bracket]) * section / sections;
+            }
+            count(middle, counts);
+            for (unsigned int j = 0; j < Lanes; ++j) {
+                for (unsigned int k = 0; k < length; ++k) {
+                    if (counts[j] <= start + k) {
+                        lower[k] = std::max(lower[k], middle[j]);
+                    } else {
+                        upper[k] = std::min(upper[k], middle[j]);
+                    }
+                }
+                if (counts[j] <= start + length) {
+                    nextLower = std::max(nextLower, middle[j]);
+                }
+            }
+        }
+
+        for (unsigned int k = 0; k < length; ++k) {
+            result[start + k - first] = 0.5 * (lower[k] + upper[k]);
+        }
+        groupLower = nextLower;
+    }
+}
+
+std::vector<double> TridiagonalEigensolver::eigenvalues(unsigned int first, unsigned int count, ThreadPool* pool) const {
+    const unsigned int size = getSize();
+    first = std::min(first, size);
+    count = std::min(count, size - first);
+    const unsigned int threads = pool ? pool->getThreadCount() : 1;
+    if (static_cast<unsigned long>(count) > static_cast<unsigned long>(size) * threads / BisectionShare) {
+        const std::vector<double> all = eigenvalues();
+        return std::vector<double>(all.begin() + first, all.begin() + first + count);
+    }
+
+    std::vector<double> result(count);
+    if (threads == 1 || count < 2) {
+        bisect(first, first + count, result.data());
+        return result;
+    }
+    pool->run([&](unsigned int thread) {
+        const unsigned int begin = static_cast<unsigned int>(static_cast<unsigned long>(count) * thread / threads);
+        const unsigned int end = static_cast<unsigned int>(static_cast<unsigned long>(count) * (thread + 1) / threads);
+        if (begin < end) {
+            bisect(first + begin, first + end, result.data() + begin);
+        }
+    });
+    return result;
+}
+
+std::vector<double> TridiagonalEigensolver::eigenvalues() const {
+    const unsigned int size = getSize();
+    std::vector<double> d(diagonal);
+    std::vector<double> e(squares);
+    const double epsilon = std::numeric_limits<double>::epsilon();
+    const double epsilonSquare = epsilon * epsilon;
+
+    // root free QL iterations of Pal, Walker and Kahan on the squared off diagonal
+    for (unsigned int l = 0; l < size; ++l) {
+        unsigned int iterations = 0;
+        while (true) {
+            // deflate at the first negligible off diagonal element below l
+            unsigned int m = l;
+            while (m + 1 < size && e[m] > epsilonSquare * std::abs(d[m] * d[m + 1])) {
+                ++m;
+            }
+            if (m == l) {
+                break;
+            }
+            if (iterations++ == MaximumQLIterations) {
+                throw std::runtime_error("the eigenvalue " + std::to_string(l) + " of the tridiagonal matrix did not converge");
+            }
+
+            // Wilkinson shift of the leading 2x2 block
+            const double offDiagonal = std::sqrt(e[l]);
+            double sigma = (d[l + 1] - d[l]) / (2 * offDiagonal);
+            sigma = d[l] - offDiagonal / (sigma + std::copysign(std::sqrt(sigma * sigma + 1), sigma));
+
+            double c = 1;
+            double s = 0;
+            double gamma = d[m] - sigma;
+            double p = gamma * gamma;
+            for (unsigned int i = m; i-- > l;) {
+                const double b = e[i];
+                const double r = p + b;
+                if (i + 1 != m) {
+                    e[i + 1] = s * r;
+                }
+                const double oldC = c;
+                c = p / r;
+                s = b / r;
+                const double oldGamma = gamma;
+                const double alpha = d[i];
+                gamma = c * (alpha - sigma) - s * oldGamma;
+                d[i + 1] = oldGamma + (alpha - gamma);
+                p = c != 0 ? gamma * gamma / c : oldC * b;
+            }
+            e[l] = s * p;
+            d[l] = sigma + gamma;
+        }
+    }
+
+    std::sort(d.begin(), d.end());
+    return d;
+}
+
+void TridiagonalEigensolver::eigenvectors(const std::vector<double>& values, VectorBatch<double>& result, ThreadPool* pool) const {
+    const unsigned int count = static_cast<unsigned int>(values.size());
+    assert(result.size() == getSize() && result.getMemberCount() == count);
+
+    // the clusters start at the eigenvalues with a large gap to their predecessor
+    const double gap = ClusterGap * (upperBound - lowerBound);
+    std::vector<unsigned int> clusters(1, 0);
+    for (unsigned int i = 1; i < count; ++i) {
+        if (values[i] - values[i - 1] > gap) {
+            clusters.push_back(i);
+        }
+    }
+    clusters.push_back(count);
+    const unsigned int clusterCount = static_cast<unsigned int>(clusters.size()) - 1;
+
+    const unsigned int threads = pool ? pool->getThreadCount() : 1;
+    if (threads == 1 || clusterCount < 2) {
+        for (unsigned int c = 0; c < clusterCount; ++c) {
+            inverseIteration(values, clusters[c], clusters[c + 1], result);
+        }
+        return;
+    }
+    pool->run([&](unsigned int thread) {
+        for (unsigned int c = thread; c < clusterCount; c += threads) {
+            inverseIteration(values, clusters[c], clusters[c + 1], result);
+        }
+    });
+}
+
+void TridiagonalEigensolver::inverseIteration(const std::vector<double>& values, unsigned int first, unsigned int last, VectorBatch<double>& result) const {
+    typedef TridiagonalMatrix<double> Matrix;
+    const unsigned int size = getSize();
+    if (size == 1) {
+        for (unsigned int m = first; m < last; ++m) {
+            result(0, m) = 1;
+        }
+        return;
+    }
+
+    Matrix shifted(size);
+    for (unsigned int i = 0; i < size; ++i) {
+        shifted(Matrix::Upper, i) = i > 0 ? offDiagonal[i - 1] : 0.0;
+        shifted(Matrix::Lower, i) = offDiagonal[i];
+    }
+    TridiagonalFactorization<double> factorization;
+    // the vectors of the cluster are kept contiguous for the orthogonalization
+    std::vector<Vector<double>> vectors(last - first, Vector<double>(size));
+
+    for (unsigned int m = first; m < last; ++m) {
+        Vector<double>& x = vectors[m - first];
+        // a shift at the eigenvalue may hit a vanishing pivot, then it gets moved away until the solves stay finite
+        double shift = values[m];
+        for (unsigned int attempt = 0; attempt < MaximumShiftAttempts; ++attempt) {
+            for (unsigned int i = 0; i < size; ++i) {
+                shifted(Matrix::Diagonal, i) = diagonal[i] - shift;
+            }
+            factorization.factorize(shifted);
+
+            std::minstd_rand generator(m + 1);
+            for (unsigned int i = 0; i < size; ++i) {
+                x[i] = static_cast<double>(generator()) / std::minstd_rand::max() - 0.5;
+            }
+
+            bool finite = true;
+            for (unsigned int iteration = 0; iteration < InverseIterations && finite; ++iteration) {
+                factorization.solveInPlace(x);
+                for (unsigned int j = first; j < m; ++j) {
+                    const Vector<double>& other = vectors[j - first];
+                    double overlap = 0;
+                    for (unsigned int i = 0; i < size; ++i) {
+                        overlap += x[i] * other[i];
+                    }
+                    for (unsigned int i = 0; i < size; ++i) {
+                        x[i] -= overlap * other[i];
+                    }
+                }
+                double norm = 0;
+                for (unsigned int i = 0; i < size; ++i) {
+                    norm += x[i] * x[i];
+                }
+                norm = std::sqrt(norm);
+                finite = std::isfinite(norm) && norm > 0;
+                if (finite) {
+                    for (unsigned int i = 0; i < size; ++i) {
+                        x[i] /= norm;
+                    }
+                }
+            }
+            if (finite) {
+                break;
+            }
+            shift += (tolerance + pivot) * (1u << (2 * attempt));
+        }
+    }
+
+    for (unsigned int i = 0; i < size; ++i) {
+        double* row = result.row(i);
+        for (unsigned int m = first; m < last; ++m) {
+            row[m] = vectors[m - first][i];
+        }
+    }
+}
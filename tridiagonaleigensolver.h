@@ -0,0 +1,139 @@
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include "VectorBatch.h"
+#include "threadpool.h"
+
+/**
+ * @brief The TridiagonalEigensolver class computes eigenvalues of a real symmetric tridiagonal matrix
+ * \f[
+ *      T = \begin{pmatrix}
+ *          d_0    & e_0    &        &           \\
+ *          e_0    & d_1    & \ddots &           \\
+ *                 & \ddots & \ddots & e_{n-2}   \\
+ *                 &        & e_{n-2} & d_{n-1}  \\
+ *      \end{pmatrix}.
+ * \f]
+ *        Selected eigenvalues get found by bisection with the Sturm sequence count of the \f$ LDL^T \f$ factorization
+ *        of \f$ T - x \f$, which costs \f$ O(N) \f$ per count and a fixed number of counts per eigenvalue, so the lowest
+ *        few eigenvalues or the eigenvalues of an energy window of a large grid are cheap. The eigenvalues of a range
+ *        get distributed over the threads of a ThreadPool. The whole spectrum gets computed with the implicit QL
+ *        algorithm with Wilkinson shifts and a deflation test, which costs \f$ O(N^2) \f$ and is used automatically
+ *        when most of the eigenvalues are requested. The eigenvectors of selected eigenvalues get computed by inverse
+ *        iteration with one TridiagonalFactorization per shift.
+ */
+class TridiagonalEigensolver
+{
+public:
+    /**
+     * @brief TridiagonalEigensolver Copy the lines of the matrix.
+     * @param Diagonal The main diagonal \f$ d_i \f$.
+     * @param OffDiagonal The off diagonal \f$ e_i \f$ between row i and i + 1, only the first getSize() - 1 elements are used.
+     */
+    TridiagonalEigensolver(const std::vector<double>& Diagonal, const std::vector<double>& OffDiagonal);
+
+    /**
+     * @brief #count Return the count of eigenvalues below an energy.
+     * @param energy The energy \f$ x \f$.
+     * @return The count of negative pivots of \f$ T - x = LDL^T \f$.
+     */
+    unsigned int count(double energy) const;
+
+    /**
+     * @brief #window Return the index range of the eigenvalues in an energy window.
+     * @param lower The lower end of the window, may be minus infinity.
+     * @param upper The upper end of the window, may be infinity.
+     * @return The index of the lowest eigenvalue in [lower, upper) and the index behind the highest one.
+     */
+    std::pair<unsigned int, unsigned int> window(double lower, double upper) const;
+
+    /**
+     * @brief #eigenvalue Return a single eigenvalue by bisection.
+     * @param index The index of the eigenvalue in accending order.
+     * @return The eigenvalue \f$ \lambda_{index} \f$.
+     */
+    double eigenvalue(unsigned int index) const;
+
+    /**
+     * @brief #eigenvalues Return a range of eigenvalues in accending order.
+     * @param first The index of the lowest eigenvalue.
+     * @param count The count of eigenvalues, the range gets clamped to the size of the matrix.
+     * @param pool The threads to distribute the eigenvalues over or nullptr.
+     * @return The eigenvalues \f$ \lambda_{first}, \dots, \lambda_{first + count - 1} \f$.
+     */
+    std::vector<double> eigenvalues(unsigned int first, unsigned int count, ThreadPool* pool = nullptr) const;
+
+    /**
+     * @brief #eigenvalues Return all eigenvalues in accending order with the implicit QL algorithm.
+     * @return The getSize() eigenvalues.
+     * @throw std::runtime_error if an eigenvalue does not converge.
+     */
+    std::vector<double> eigenvalues() const;
+
+    /**
+     * @brief #eigenvectors Compute the normalized eigenvectors of eigenvalues by inverse iteration.
+     *        Every shift \f$ T - \lambda \f$ gets factorized once and solved a few times starting from a pseudo random
+     *        vector. The vectors of eigenvalues closer than a millionth of the spectral width form a cluster and get
+     *        orthogonalized against each other, the clusters get distributed over the threads of the pool.
+     * @param values The eigenvalues in accending order, e.g. of #eigenvalues.
+     * @param result The batch with getSize() elements and a member per eigenvalue to write the eigenvectors into.
+     * @param pool The threads to distribute the clusters over or nullptr.
+     */
+    void eigenvectors(const std::vector<double>& values, VectorBatch<double>& result, ThreadPool* pool = nullptr) const;
+
+    /**
+     * @brief #getLowerBound Return the lower Gershgorin bound of the spectrum.
+     * @return A value below all eigenvalues.
+     */
+    double getLowerBound() const { return lowerBound; }
+
+    /**
+     * @brief #getUpperBound Return the upper Gershgorin bound of the spectrum.
+     * @return A value above all eigenvalues.
+     */
+    double getUpperBound() const { return upperBound; }
+
+    /**
+     * @brief #getSize Return the size of the matrix.
+     * @return The count of eigenvalues.
+     */
+    unsigned int getSize() const { return static_cast<unsigned int>(diagonal.size()); }
+
+private:
+    /**
+     * @brief #bisect Find the eigenvalues of a range by bisection.
+     *        Groups of Lanes neighbouring eigenvalues get bisected together and share the counts of their midpoints.
+     * @param first The index of the lowest eigenvalue.
+     * @param last The index behind the highest eigenvalue.
+     * @param result The array to write the last - first eigenvalues into.
+     */
+    void bisect(unsigned int first, unsigned int last, double* result) const;
+
+    static const unsigned int Lanes = 4; //! The count of Sturm counts evaluated in one pass over the matrix
+
+    /**
+     * @brief #count Evaluate the Sturm counts of Lanes energies in one pass.
+     * @param energies The Lanes energies.
+     * @param counts The array to write the Lanes counts into.
+     */
+    void count(const double* energies, unsigned int* counts) const;
+
+    /**
+     * @brief #inverseIteration Compute the eigenvectors of a cluster of eigenvalues.
+     * @param values The eigenvalues.
+     * @param first The index of the first eigenvalue of the cluster.
+     * @param last The index behind the last eigenvalue of the cluster.
+     * @param result The batch to write the members first to last into.
+     */
+    void inverseIteration(const std::vector<double>& values, unsigned int first, unsigned int last, VectorBatch<double>& result) const;
+
+    std::vector<double> diagonal;    //! The main diagonal \f$ d_i \f$
+    std::vector<double> offDiagonal; //! The off diagonal \f$ e_i \f$ with a trailing zero
+    std::vector<double> squares;     //! The squares \f$ e_i^2 \f$ used by the Sturm count
+    double pivot;                    //! The smallest pivot magnitude of the Sturm count
+    double tolerance;                //! The absolute accuracy of the bisection
+    double lowerBound;
+    double upperBound;
+};